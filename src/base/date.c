@@ -0,0 +1,106 @@
+/* file : date.c */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "date.h"
+
+// checking for validity of a date
+int date_check(char * date)
+{
+	char * day, * month, * year;
+	//char * temp_date = calloc(strlen(date) + 1, sizeof(char));		// create a temp date, since strtok modifies initial string, and we do not want that
+	char temp_date[12];
+	strcpy(temp_date, date);
+
+	char * saveptr;		// strtok_r instead of strtok, so that dates can be checked by queries running in parallel
+	char *str = strtok_r(temp_date, "-", &saveptr);
+	int i = 1;
+	while(str != NULL)
+	{
+		switch (i)
+	    {
+	    	case 1: day = str; break;
+	        case 2: month = str; break;
+	        case 3: year = str; break;
+	    }
+	    i++;
+	    str = strtok_r(NULL, "-", &saveptr);
+	}
+
+	if (i != 4)
+		return 0;
+	if (strlen(day) > 2 || strlen(month) > 2 || strlen(year) != 4)
+		return 0;
+	for (int i = 0; i < strlen(day); i++)
+	{
+		if (day[i] < '0' || day[i] > '9')
+			return 0;
+	}
+	for (int i = 0; i < strlen(month); i++)
+	{
+		if (month[i] < '0' || month[i] > '9')
+			return 0;
+	}
+
+	for (int i = 0; i < strlen(year); i++)
+	{
+		if (year[i] < '0' || year[i] > '9')
+			return 0;
+	}
+
+	if (atoi(day) < 1 || atoi(day) > 30 || atoi(month) < 1 || atoi(month) > 12 )
+		return 0;
+
+	return 1;
+}
+
+Date date_make(int day, int month, int year)
+{
+	return year * 372 + (month - 1) * 31 + day;
+}
+
+// a date is parsed once, when it is read, and only compared as a day number from then on
+Date date_parse(const char * date)
+{
+	int field[3] = {0, 0, 0};
+	int digits[3] = {0, 0, 0};
+	int i = 0;
+
+	for (const char * c = date; *c != '\0'; c++)
+	{
+		if (*c == '-')
+		{
+			if (++i > 2)
+				return NO_DATE;
+		}
+		else if (*c >= '0' && *c <= '9')
+		{
+			field[i] = 10 * field[i] + (*c - '0');
+			digits[i]++;
+		}
+		else
+			return NO_DATE;
+	}
+
+	if (i != 2 || digits[0] < 1 || digits[0] > 2 || digits[1] < 1 || digits[1] > 2 || digits[2] != 4)
+		return NO_DATE;
+	if (field[0] < 1 || field[0] > 31 || field[1] < 1 || field[1] > 12)
+		return NO_DATE;
+
+	return date_make(field[0], field[1], field[2]);
+}
+
+Date date_today(void)
+{
+	time_t t = time(NULL);
+	struct tm tm = *localtime(&t);
+	return date_make(tm.tm_mday, tm.tm_mon + 1, tm.tm_year + 1900);
+}
+
+char * date_format(Date date, char * buffer)
+{
+	int days = date - 1;
+	snprintf(buffer, DATE_STRING_SIZE, "%d-%d-%04d", days % 372 % 31 + 1, days % 372 / 31 + 1, days / 372);
+	return buffer;
+}
@@ -0,0 +1,21 @@
+/* file : date.h */
+#pragma once
+#include <stdint.h>
+
+/* a date is kept as a day number : every month takes 31 days, so that day numbers order dates the same way as the
+   dates themselves, and day, month and year are recovered with a division. Day numbers of valid dates are positive */
+typedef int32_t Date;
+
+#define NO_DATE 0				// day number of a missing (or invalid) date
+#define DATE_STRING_SIZE 20		// "dd-mm-yyyy" and its '\0', with room for the year of any day number
+
+/* checks that given string is a valid date of the form dd-mm-yyyy (as given in commands) */
+int date_check(char * date);
+/* returns the day number of a date of the form d-m-yyyy (day and month of one or two digits), NO_DATE if it is not a date */
+Date date_parse(const char * date);
+/* day number of a given day, month and year */
+Date date_make(int day, int month, int year);
+/* returns the day number of today */
+Date date_today(void);
+/* writes given date to buffer (of DATE_STRING_SIZE chars) as d-m-yyyy (day and month without leading zeros, as vaccinateNow always wrote them), and returns buffer */
+char * date_format(Date date, char * buffer);
@@ -2,76 +2,132 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
 #include "bloom.h"
+#include "cuckoo.h"
+#include "xor_filter.h"
 #include "skip_list.h"
+#include "arena.h"
+#include "date_index.h"
+#include "projection.h"
 #include "items.h"
 #include <assert.h>
 
+#define XOR_OVERFLOW 64		// least number of persons vaccinated after an xor filter is built, before it is built again
+
+/* a citizen record and its strings are a single block of the citizens arena : the id, name and surname follow the struct */
 struct citizen_info {
-	char * id;
-	char * name;
-	char * surname;
-	int age;
+	uint64_t key;							// integer key of the id (see citizen_key)
 	CountryInfo country;
+	int age;
+	int num_of_viruses;						// viruses the citizen is in a skip list of, in ascending virus id :
+	int viruses_capacity;
+	struct citizen_virus * viruses;			// inline_viruses, until they do not fit
+	struct citizen_virus inline_viruses[CITIZEN_INLINE_VIRUSES];
+	unsigned int name_offset;				// offsets of name and surname in strings (id is at its start)
+	unsigned int surname_offset;
+	char strings[];
 };
 
 struct virus_info {
 	char * virus_name;						// name of the virus
+	int virus_id;							// dense id of the virus, in order of creation
+	FilterKind filter_kind;					// membership filter of the vaccinated persons :
 	Bloom bloom_filter;						// bloom filter for virus
+	Cuckoo cuckoo_filter;					// cuckoo filter (the persons not in the xor filter, for FILTER_XOR)
+	XorFilter xor_filter;					// xor filter (NULL until it is built)
 	SkipList vaccinated_persons;			// vaccinated persons skip list for virus
 	SkipList not_vaccinated_persons;		// not vaccinated persons skip list for virus
+	struct country_counters * counters;		// live counters of the persons of the skip lists, indexed by country id
+	int counters_capacity;
+	Projection vaccinated_projection;		// country, age group and date of the vaccinated persons, for scans of all countries by date
+	bool projection_stale;					// a vaccinated person was removed, the projection is rebuilt before its next scan
+	pthread_mutex_t lazy_mutex;				// queries running in parallel build the xor filter, sort the date indexes and rebuild the projection one at a time
+};
+
+/* number of vaccinated and not vaccinated persons of a country, per age group */
+struct country_counters {
+	int vaccinated[AGE_GROUPS];
+	int not_vaccinated[AGE_GROUPS];
+	DateIndex vaccination_dates[AGE_GROUPS];		// dates of vaccination of the vaccinated persons (NULL until the first one)
 };
 
 struct country_info {
 	char * country_name;
+	int country_id;							// dense id of the country, in order of creation
 	unsigned long population;
 };
 
-CitizenInfo citizen_info_create(char * id, char * name, char * surname, int age, CountryInfo country)
+uint64_t citizen_key(const char * id)
+{
+	uint64_t key = 1;
+	int length = 0;
+	for ( ; id[length] != '\0'; length++)
+	{
+		if (id[length] < '0' || id[length] > '9' || length == CITIZEN_KEY_DIGITS)
+			return NO_CITIZEN_KEY;
+		key = key * 10 + (id[length] - '0');
+	}
+	return (length == 0) ? NO_CITIZEN_KEY : key;
+}
+
+CitizenInfo citizen_info_create(Arena arena, char * id, char * name, char * surname, int age, CountryInfo country)
 {
-	CitizenInfo info = malloc(sizeof(struct citizen_info));
+	size_t id_length = strlen(id) + 1, name_length = strlen(name) + 1, surname_length = strlen(surname) + 1;
+
+	CitizenInfo info = arena_alloc(arena, sizeof(struct citizen_info) + id_length + name_length + surname_length);
 	if (info == NULL)
-		fprintf(stderr, "Error : citizen_info_create -> malloc\n");
+		fprintf(stderr, "Error : citizen_info_create -> arena_alloc\n");
 	assert(info != NULL);
 
-	info->id = malloc(strlen(id) + 1);
-	strcpy(info->id, id);
-	info->name = malloc(strlen(name) + 1);
-	strcpy(info->name, name);
-	info->surname = malloc(strlen(surname) + 1);
-	strcpy(info->surname, surname);
+	info->key = citizen_key(id);
+	info->name_offset = id_length;
+	info->surname_offset = id_length + name_length;
+	memcpy(info->strings, id, id_length);
+	memcpy(info->strings + info->name_offset, name, name_length);
+	memcpy(info->strings + info->surname_offset, surname, surname_length);
 	info->age = age;
 	info->country = country;
+	info->num_of_viruses = 0;
+	info->viruses_capacity = CITIZEN_INLINE_VIRUSES;
+	info->viruses = info->inline_viruses;
 	country_population_inc(country);		// new citizen from given country was recorded and inserted into database
 
 	return info;
 }
 
-void citizen_info_destroy(CitizenInfo info)
+// size of the heap chunk of a malloc of given size : an 8 byte header, rounded to a multiple of 16 bytes, and at least 32 bytes
+static size_t malloc_chunk(size_t size)
 {
-	if (info == NULL)
-		fprintf(stderr, "Error : citizen_info_delete -> malloc\n");
-	assert(info != NULL);
+	size_t chunk = (size + 8 + 15) / 16 * 16;
+	return (chunk < 32) ? 32 : chunk;
+}
 
-	free(info->id);
-	free(info->name);
-	free(info->surname);
-	free(info);
+size_t citizen_info_separate_size(CitizenInfo info)
+{
+	// a struct with pointers to the key, id, name, surname, age and country, plus a separate malloc for each string
+	size_t record = sizeof(uint64_t) + 3 * sizeof(char *) + sizeof(int) + sizeof(CountryInfo);
+	return malloc_chunk(record) + malloc_chunk(strlen(get_citizen_id(info)) + 1) + malloc_chunk(strlen(get_citizen_name(info)) + 1) + malloc_chunk(strlen(get_citizen_surname(info)) + 1);
 }
 
 char * get_citizen_id(CitizenInfo info)
 {
-	return info->id;
+	return info->strings;
+}
+
+uint64_t get_citizen_key(CitizenInfo info)
+{
+	return info->key;
 }
 
 char * get_citizen_name(CitizenInfo info)
 {
-	return info->name;
+	return info->strings + info->name_offset;
 }
 
 char * get_citizen_surname(CitizenInfo info)
 {
-	return info->surname;
+	return info->strings + info->surname_offset;
 }
 
 char * get_citizen_country(CitizenInfo info)
@@ -86,13 +142,76 @@ int get_citizen_age(CitizenInfo info)
 
 void citizen_info_print(CitizenInfo info)
 {
-	printf("%s %s %s %s %d\n", info->id, info->name, info->surname, get_country_name(info->country), info->age);
+	printf("%s %s %s %s %d\n", get_citizen_id(info), get_citizen_name(info), get_citizen_surname(info), get_country_name(info->country), info->age);
+}
+
+void citizen_set_virus(CitizenInfo info, int virus_id, bool vaccinated, Date date)
+{
+	// viruses are kept sorted by id, most citizens have one or two of them, so they are searched linearly
+	int i = 0;
+	while (i < info->num_of_viruses && info->viruses[i].virus_id < virus_id)
+		i++;
+
+	if (i == info->num_of_viruses || info->viruses[i].virus_id != virus_id)
+	{
+		if (info->num_of_viruses == info->viruses_capacity)
+		{
+			int capacity = 2 * info->viruses_capacity;
+			struct citizen_virus * viruses = malloc(capacity * sizeof(struct citizen_virus));
+			if (viruses == NULL)
+				fprintf(stderr, "Error : citizen_set_virus -> malloc\n");
+			assert(viruses != NULL);
+
+			memcpy(viruses, info->viruses, info->num_of_viruses * sizeof(struct citizen_virus));
+			if (info->viruses != info->inline_viruses)
+				free(info->viruses);
+			info->viruses = viruses;
+			info->viruses_capacity = capacity;
+		}
+		memmove(&info->viruses[i + 1], &info->viruses[i], (info->num_of_viruses - i) * sizeof(struct citizen_virus));
+		info->num_of_viruses++;
+	}
+
+	info->viruses[i].virus_id = virus_id;
+	info->viruses[i].vaccinated = vaccinated;
+	info->viruses[i].date = date;
+}
+
+const struct citizen_virus * get_citizen_viruses(CitizenInfo info, int * num_of_viruses)
+{
+	*num_of_viruses = info->num_of_viruses;
+	return info->viruses;
+}
+
+void citizen_info_release(CitizenInfo info)
+{
+	if (info->viruses != info->inline_viruses)
+		free(info->viruses);
+	info->viruses = info->inline_viruses;
+	info->num_of_viruses = 0;
+	info->viruses_capacity = CITIZEN_INLINE_VIRUSES;
 }
 
 /*_______________________________________________________________________________________________________________*/
 
 
-VirusInfo virus_info_create(char * virus_name, unsigned int bloom_size, int max_level, float p)
+const char * filter_kind_name(FilterKind kind)
+{
+	return (kind == FILTER_CUCKOO) ? "cuckoo" : (kind == FILTER_XOR) ? "xor" : "bloom";
+}
+
+int filter_kind_parse(const char * name)
+{
+	if (!strcmp(name, "bloom"))
+		return FILTER_BLOOM;
+	else if (!strcmp(name, "cuckoo"))
+		return FILTER_CUCKOO;
+	else if (!strcmp(name, "xor"))
+		return FILTER_XOR;
+	return -1;
+}
+
+VirusInfo virus_info_create(char * virus_name, int virus_id, FilterKind filter_kind, Bloom bloom_filter, int max_level, float p)
 {
 	VirusInfo info = malloc(sizeof(struct virus_info));
 	if (info == NULL)
@@ -101,10 +220,19 @@ VirusInfo virus_info_create(char * virus_name, unsigned int bloom_size, int max_
 
 	info->virus_name = malloc(strlen(virus_name) + 1);
 	strcpy(info->virus_name, virus_name);
+	info->virus_id = virus_id;
 
-	info->bloom_filter = bloom_create(bloom_size);
+	info->filter_kind = filter_kind;
+	info->bloom_filter = (filter_kind == FILTER_BLOOM) ? bloom_filter : NULL;
+	info->cuckoo_filter = (filter_kind == FILTER_CUCKOO) ? cuckoo_create(EXPECTED_VACCINATED) : NULL;
+	info->xor_filter = NULL;
 	info->vaccinated_persons = skip_list_create(max_level, p);
 	info->not_vaccinated_persons = skip_list_create(max_level, p);
+	info->counters = NULL;
+	info->counters_capacity = 0;
+	info->vaccinated_projection = projection_create();
+	info->projection_stale = false;
+	pthread_mutex_init(&info->lazy_mutex, NULL);
 
 	return info;
 }
@@ -116,9 +244,25 @@ void virus_info_destroy(VirusInfo info)
 	assert(info != NULL);
 
 	free(info->virus_name);
-	bloom_destroy(info->bloom_filter);
+	if (info->bloom_filter != NULL)
+		bloom_destroy(info->bloom_filter);
+	if (info->cuckoo_filter != NULL)
+		cuckoo_destroy(info->cuckoo_filter);
+	if (info->xor_filter != NULL)
+		xor_destroy(info->xor_filter);
 	skip_list_destroy(info->vaccinated_persons);
 	skip_list_destroy(info->not_vaccinated_persons);
+	for (int i = 0; i < info->counters_capacity; i++)
+	{
+		for (int j = 0; j < AGE_GROUPS; j++)
+		{
+			if (info->counters[i].vaccination_dates[j] != NULL)
+				date_index_destroy(info->counters[i].vaccination_dates[j]);
+		}
+	}
+	free(info->counters);
+	projection_destroy(info->vaccinated_projection);
+	pthread_mutex_destroy(&info->lazy_mutex);
 
 	free(info);
 }
@@ -128,11 +272,181 @@ char * get_virus_name(VirusInfo info)
 	return info->virus_name;
 }
 
+int get_virus_id(VirusInfo info)
+{
+	return info->virus_id;
+}
+
 Bloom get_bloom_filter(VirusInfo info)
 {
 	return info->bloom_filter;
 }
 
+/* inserts a vaccinated person into a bloom filter */
+static void bloom_insert_person(void * data, Date date, void * arg)
+{
+	bloom_insert((Bloom) arg, (unsigned char *) get_citizen_id(data));
+}
+
+void set_bloom_filter(VirusInfo info, Bloom bloom_filter)
+{
+	skip_list_traverse(info->vaccinated_persons, bloom_insert_person, bloom_filter);
+	bloom_destroy(info->bloom_filter);
+	info->bloom_filter = bloom_filter;
+}
+
+FilterKind get_virus_filter_kind(VirusInfo info)
+{
+	return info->filter_kind;
+}
+
+/* a cuckoo filter being filled from a skip list, and whether a person did not fit */
+struct cuckoo_fill {
+	Cuckoo cuckoo;
+	bool full;
+};
+
+/* inserts a vaccinated person into a cuckoo filter */
+static void cuckoo_insert_person(void * data, Date date, void * arg)
+{
+	struct cuckoo_fill * fill = arg;
+	if (!cuckoo_insert(fill->cuckoo, hash_once((unsigned char *) get_citizen_id(data))))
+		fill->full = true;
+}
+
+/* replaces the cuckoo filter of the virus with one of given capacity (or larger, if they do not fit) holding all of its vaccinated persons */
+static void rebuild_cuckoo(VirusInfo info, unsigned long capacity)
+{
+	struct cuckoo_fill fill;
+	do
+	{
+		fill.cuckoo = cuckoo_create(capacity);
+		fill.full = false;
+		skip_list_traverse(info->vaccinated_persons, cuckoo_insert_person, &fill);
+		if (fill.full)
+		{
+			cuckoo_destroy(fill.cuckoo);
+			capacity *= 2;
+		}
+	} while (fill.full);
+
+	if (info->cuckoo_filter != NULL)
+		cuckoo_destroy(info->cuckoo_filter);
+	info->cuckoo_filter = fill.cuckoo;
+}
+
+/* appends the hash of a vaccinated person to an array */
+static void hash_person(void * data, Date date, void * arg)
+{
+	uint64_t ** hash = arg;
+	*(*hash)++ = hash_once((unsigned char *) get_citizen_id(data));
+}
+
+void virus_filter_seal(VirusInfo info)
+{
+	if (info->filter_kind == FILTER_CUCKOO && cuckoo_count(info->cuckoo_filter) != (unsigned long) skip_list_size(info->vaccinated_persons))
+		rebuild_cuckoo(info, (skip_list_size(info->vaccinated_persons) > EXPECTED_VACCINATED) ? skip_list_size(info->vaccinated_persons) : EXPECTED_VACCINATED);
+	if (info->filter_kind != FILTER_XOR)
+		return;
+
+	long num_of_keys = skip_list_size(info->vaccinated_persons);
+	uint64_t * hashes = malloc((num_of_keys + 1) * sizeof(uint64_t));
+	if (hashes == NULL)
+		fprintf(stderr, "Error : virus_filter_seal -> malloc\n");
+	assert(hashes != NULL);
+
+	uint64_t * next = hashes;
+	skip_list_traverse(info->vaccinated_persons, hash_person, &next);
+	XorFilter xor_filter = xor_create(hashes, num_of_keys);
+	free(hashes);
+
+	// persons vaccinated from now on go into a cuckoo filter, a fraction of the size of the xor filter, until it is full and the xor filter is built again
+	if (info->cuckoo_filter != NULL)
+		cuckoo_destroy(info->cuckoo_filter);
+	info->cuckoo_filter = cuckoo_create((num_of_keys / 16 > XOR_OVERFLOW) ? num_of_keys / 16 : XOR_OVERFLOW);
+
+	// the xor filter is set last, so that a query that finds it built (see virus_filter_check_hash) finds the cuckoo filter as well
+	if (info->xor_filter != NULL)
+		xor_destroy(info->xor_filter);
+	__atomic_store_n(&info->xor_filter, xor_filter, __ATOMIC_RELEASE);
+}
+
+void virus_filter_insert(VirusInfo info, char * citizenID)
+{
+	if (info->filter_kind == FILTER_BLOOM)
+	{
+		bloom_insert(info->bloom_filter, (unsigned char *) citizenID);
+		return;
+	}
+	if (info->filter_kind == FILTER_XOR && info->xor_filter == NULL)		// the person is in the skip list the xor filter is going to be built from
+		return;
+
+	// a full cuckoo filter is rebuilt from the skip list, which already holds the person
+	if (!cuckoo_insert(info->cuckoo_filter, hash_once((unsigned char *) citizenID)))
+	{
+		if (info->filter_kind == FILTER_CUCKOO)
+			rebuild_cuckoo(info, 2 * cuckoo_capacity(info->cuckoo_filter));
+		else
+			virus_filter_seal(info);
+	}
+}
+
+bool virus_filter_check(VirusInfo info, char * citizenID)
+{
+	if (info->filter_kind == FILTER_BLOOM)
+		return bloom_check(info->bloom_filter, (unsigned char *) citizenID);
+	return virus_filter_check_hash(info, citizenID, hash_once((unsigned char *) citizenID));
+}
+
+void virus_filter_prefetch(VirusInfo info, char * citizenID, uint64_t hash)
+{
+	if (info->filter_kind == FILTER_BLOOM)
+		bloom_prefetch(info->bloom_filter, (unsigned char *) citizenID, hash);
+	else if (info->filter_kind == FILTER_CUCKOO)
+		cuckoo_prefetch(info->cuckoo_filter, hash);
+	else
+	{
+		XorFilter xor_filter = __atomic_load_n(&info->xor_filter, __ATOMIC_ACQUIRE);		// NULL until built, and then its cuckoo filter is there as well
+		if (xor_filter != NULL)
+		{
+			xor_prefetch(xor_filter, hash);
+			cuckoo_prefetch(info->cuckoo_filter, hash);
+		}
+	}
+}
+
+bool virus_filter_check_hash(VirusInfo info, char * citizenID, uint64_t hash)
+{
+	if (info->filter_kind == FILTER_BLOOM)
+		return bloom_check_hash(info->bloom_filter, (unsigned char *) citizenID, hash);
+	if (info->filter_kind == FILTER_CUCKOO)
+		return cuckoo_check(info->cuckoo_filter, hash);
+
+	// the xor filter of a virus created after the records file was loaded is built by its first check, which may run in parallel with other queries
+	if (__atomic_load_n(&info->xor_filter, __ATOMIC_ACQUIRE) == NULL)
+	{
+		pthread_mutex_lock(&info->lazy_mutex);
+		if (info->xor_filter == NULL)
+			virus_filter_seal(info);
+		pthread_mutex_unlock(&info->lazy_mutex);
+	}
+	return xor_check(info->xor_filter, hash) || cuckoo_check(info->cuckoo_filter, hash);
+}
+
+void virus_filter_reserve(VirusInfo info, unsigned long num_of_keys)
+{
+	if (info->filter_kind == FILTER_CUCKOO && cuckoo_capacity(info->cuckoo_filter) < num_of_keys)
+		rebuild_cuckoo(info, num_of_keys);
+}
+
+unsigned long virus_filter_memory(VirusInfo info)
+{
+	if (info->filter_kind == FILTER_BLOOM)
+		return bloom_memory(info->bloom_filter);
+	unsigned long bytes = (info->cuckoo_filter != NULL) ? cuckoo_memory(info->cuckoo_filter) : 0;
+	return (info->xor_filter != NULL) ? bytes + xor_memory(info->xor_filter) : bytes;
+}
+
 SkipList get_vacc_list(VirusInfo info)
 {
 	return info->vaccinated_persons;
@@ -143,6 +457,190 @@ SkipList get_non_vacc_list(VirusInfo info)
 	return info->not_vaccinated_persons;
 }
 
+int age_group(int age)
+{
+	if (age < 20)
+		return 0;
+	else if (age < 40)
+		return 1;
+	else if (age < 60)
+		return 2;
+	else
+		return 3;
+}
+
+/* makes room in the counters of the virus for countries with ids up to capacity - 1 */
+static void counters_reserve(VirusInfo info, int capacity)
+{
+	if (capacity <= info->counters_capacity)
+		return;
+
+	int prev_capacity = info->counters_capacity;
+	info->counters_capacity = capacity;
+	info->counters = realloc(info->counters, info->counters_capacity * sizeof(struct country_counters));
+	if (info->counters == NULL)
+		fprintf(stderr, "Error : counters_reserve -> realloc\n");
+	assert(info->counters != NULL);
+	memset(&info->counters[prev_capacity], 0, (info->counters_capacity - prev_capacity) * sizeof(struct country_counters));
+}
+
+void virus_count(VirusInfo info, CitizenInfo citizen, bool vaccinated, Date date, int change)
+{
+	int country_id = get_country_id(citizen->country);
+	if (country_id >= info->counters_capacity)
+		counters_reserve(info, 2 * (country_id + 1));
+
+	struct country_counters * counters = &info->counters[country_id];
+	int group = age_group(citizen->age);
+	if (!vaccinated)
+	{
+		counters->not_vaccinated[group] += change;
+		return;
+	}
+
+	counters->vaccinated[group] += change;
+	if (counters->vaccination_dates[group] == NULL)
+		counters->vaccination_dates[group] = date_index_create();
+	if (change > 0)
+	{
+		date_index_add(counters->vaccination_dates[group], date);
+		projection_append(info->vaccinated_projection, country_id, group, date);
+	}
+	else
+	{
+		date_index_remove(counters->vaccination_dates[group], date);
+		info->projection_stale = true;
+	}
+}
+
+int virus_counted(VirusInfo info, int country_id, bool vaccinated, int group)
+{
+	if (country_id >= info->counters_capacity)		// no person of the country was ever counted for the virus
+		return 0;
+
+	int * counters = vaccinated ? info->counters[country_id].vaccinated : info->counters[country_id].not_vaccinated;
+	if (group >= 0)
+		return counters[group];
+
+	int total = 0;
+	for (int i = 0; i < AGE_GROUPS; i++)
+		total += counters[i];
+	return total;
+}
+
+/* adds the date of a vaccinated person to the date index of its country and age group, and the person to the projection of the virus */
+static void index_date(void * data, Date date, void * arg)
+{
+	CitizenInfo citizen = data;
+	VirusInfo info = arg;
+	int country_id = get_country_id(citizen->country);
+	struct country_counters * counters = &info->counters[country_id];
+	int group = age_group(citizen->age);
+
+	if (counters->vaccination_dates[group] == NULL)
+		counters->vaccination_dates[group] = date_index_create();
+	date_index_add(counters->vaccination_dates[group], date);
+	projection_append(info->vaccinated_projection, country_id, group, date);
+}
+
+/* appends a vaccinated person to the projection of the virus */
+static void project_person(void * data, Date date, void * arg)
+{
+	CitizenInfo citizen = data;
+	projection_append((Projection) arg, get_country_id(citizen->country), age_group(citizen->age), date);
+}
+
+/* rebuilds the projection of the vaccinated persons from their skip list */
+static void project_vaccinated(VirusInfo info)
+{
+	projection_clear(info->vaccinated_projection);
+	skip_list_traverse(info->vaccinated_persons, project_person, info->vaccinated_projection);
+	__atomic_store_n(&info->projection_stale, false, __ATOMIC_RELEASE);
+}
+
+void virus_recount(VirusInfo info, int num_of_countries)
+{
+	counters_reserve(info, num_of_countries);
+
+	for (int i = 0; i < info->counters_capacity; i++)
+	{
+		for (int j = 0; j < AGE_GROUPS; j++)
+		{
+			if (info->counters[i].vaccination_dates[j] != NULL)
+				date_index_destroy(info->counters[i].vaccination_dates[j]);
+		}
+	}
+	memset(info->counters, 0, info->counters_capacity * sizeof(struct country_counters));
+
+	// one group by pass over each skip list counts the persons of all countries and age groups
+	int * counts = calloc((size_t) num_of_countries * AGE_GROUPS + 1, sizeof(int));
+	if (counts == NULL)
+		fprintf(stderr, "Error : virus_recount -> calloc\n");
+	assert(counts != NULL);
+
+	skip_list_GroupByCountryAge(info->vaccinated_persons, NO_DATE, NO_DATE, counts, num_of_countries);
+	for (int i = 0; i < num_of_countries; i++)
+		memcpy(info->counters[i].vaccinated, &counts[i * AGE_GROUPS], sizeof(info->counters[i].vaccinated));
+
+	memset(counts, 0, (size_t) num_of_countries * AGE_GROUPS * sizeof(int));
+	skip_list_GroupByCountryAge(info->not_vaccinated_persons, NO_DATE, NO_DATE, counts, num_of_countries);
+	for (int i = 0; i < num_of_countries; i++)
+		memcpy(info->counters[i].not_vaccinated, &counts[i * AGE_GROUPS], sizeof(info->counters[i].not_vaccinated));
+	free(counts);
+
+	// dates of vaccination come in order of citizen id, so they are sorted once they are all indexed
+	projection_clear(info->vaccinated_projection);
+	skip_list_traverse(info->vaccinated_persons, index_date, info);
+	info->projection_stale = false;
+	for (int i = 0; i < info->counters_capacity; i++)
+	{
+		for (int j = 0; j < AGE_GROUPS; j++)
+		{
+			if (info->counters[i].vaccination_dates[j] != NULL)
+				date_index_sort(info->counters[i].vaccination_dates[j]);
+		}
+	}
+}
+
+int virus_counted_in_range(VirusInfo info, int country_id, int group, Date from, Date to)
+{
+	if (country_id >= info->counters_capacity)
+		return 0;
+
+	int total = 0;
+	for (int i = 0; i < AGE_GROUPS; i++)
+	{
+		DateIndex index = info->counters[country_id].vaccination_dates[i];
+		if ((group < 0 || group == i) && index != NULL)
+		{
+			// dates added out of order are sorted by the first count after them, which may run in parallel with other queries
+			if (!date_index_sorted(index))
+			{
+				pthread_mutex_lock(&info->lazy_mutex);
+				date_index_sort(index);
+				pthread_mutex_unlock(&info->lazy_mutex);
+			}
+			total += date_index_count(index, from, to);
+		}
+	}
+	return total;
+}
+
+void virus_counted_in_range_all(VirusInfo info, Date from, Date to, int * counts, int num_of_countries)
+{
+	// a stale projection is rebuilt by the first scan after the removal, which may run in parallel with other queries
+	if (__atomic_load_n(&info->projection_stale, __ATOMIC_ACQUIRE))
+	{
+		pthread_mutex_lock(&info->lazy_mutex);
+		if (info->projection_stale)
+			project_vaccinated(info);
+		pthread_mutex_unlock(&info->lazy_mutex);
+	}
+
+	// a single scan of the contiguous columns of the projection counts all countries, instead of two binary searches per country and age group
+	projection_count_all(info->vaccinated_projection, from, to, counts, num_of_countries);
+}
+
 void virus_info_print(VirusInfo info)
 {
 	printf("%s\n", info->virus_name);
@@ -155,7 +653,7 @@ void virus_info_print(VirusInfo info)
 /*_______________________________________________________________*/
 
 
-CountryInfo country_info_create(char * country_name)
+CountryInfo country_info_create(char * country_name, int country_id)
 {
 	CountryInfo info = malloc(sizeof(struct country_info));
 	if (info == NULL)
@@ -164,6 +662,7 @@ CountryInfo country_info_create(char * country_name)
 
 	info->country_name = malloc(strlen(country_name) + 1);
 	strcpy(info->country_name, country_name);
+	info->country_id = country_id;
 	info->population = 0;
 
 	return info;
@@ -184,6 +683,16 @@ char * get_country_name(CountryInfo info)
 	return info->country_name;
 }
 
+int get_country_id(CountryInfo info)
+{
+	return info->country_id;
+}
+
+CountryInfo get_citizen_country_info(CitizenInfo info)
+{
+	return info->country;
+}
+
 void country_population_inc(CountryInfo info)
 {
 	info->population++;
@@ -198,106 +707,3 @@ void country_info_print(CountryInfo info)
 {
 	printf("%s\n", info->country_name);
 }
-
-/*______________________________________________________________________*/
-// utility functions for dates
-
-// checking for validity of a date
-int date_check(char * date)
-{
-	char * day, * month, * year;
-	//char * temp_date = calloc(strlen(date) + 1, sizeof(char));		// create a temp date, since strtok modifies initial string, and we do not want that
-	char temp_date[12];
-	strcpy(temp_date, date);
-
-	char *str = strtok(temp_date, "-");
-	int i = 1;
-	while(str != NULL)
-	{
-		switch (i)
-	    {
-	    	case 1: day = str; break;
-	        case 2: month = str; break;
-	        case 3: year = str; break;
-	    }
-	    i++;
-	    str = strtok(NULL, "-");
-	}
-
-	if (i != 4)
-		return 0;
-	if (strlen(day) > 2 || strlen(month) > 2 || strlen(year) != 4)
-		return 0;
-	for (int i = 0; i < strlen(day); i++)
-	{
-		if (day[i] < '0' || day[i] > '9')
-			return 0;
-	}
-	for (int i = 0; i < strlen(month); i++)
-	{
-		if (month[i] < '0' || month[i] > '9')
-			return 0;
-	}
-
-	for (int i = 0; i < strlen(year); i++)
-	{
-		if (year[i] < '0' || year[i] > '9')
-			return 0;
-	}
-
-	if (atoi(day) < 1 || atoi(day) > 30 || atoi(month) < 1 || atoi(month) > 12 )
-		return 0;
-
-	return 1;
-}
-
-// comparing two valid dates
-int date_cmp(char * date1, char * date2)
-{
-	int day1, month1, year1;
-	int day2, month2, year2;
-
-	//char * temp_date1 = calloc(strlen(date1) + 1, sizeof(char));	// create temp dates, since strtok modifies initial strings, and we do not want that
-	char temp_date1[12];
-	strcpy(temp_date1, date1);
-	//char * temp_date2 = calloc(strlen(date2) + 1, sizeof(char));
-	char temp_date2[12];
-	strcpy(temp_date2, date2);
-	
-
-	char *str1 = strtok(temp_date1, "-");
-	int i = 1;
-	while(str1 != NULL)
-	{
-		switch (i)
-	    {
-	    	case 1: day1 = atoi(str1); break;
-	        case 2: month1 = atoi(str1); break;
-	        case 3: year1 = atoi(str1); break;
-	    }
-	    i++;
-	    str1 = strtok(NULL, "-");
-	}
-
-	char *str2 = strtok(temp_date2, "-");
-	i = 1;
-	while(str2 != NULL)
-	{
-		switch (i)
-	    {
-	    	case 1: day2 = atoi(str2); break;
-	        case 2: month2 = atoi(str2); break;
-	        case 3: year2 = atoi(str2); break;
-	    }
-	    i++;
-	    str2 = strtok(NULL, "-");
-	}
-
-	if (year2 > year1) return -1;
-	else if (year2 < year1) return 1;
-	else if (month2 > month1) return -1;
-	else if (month2 < month1) return 1;
-	else if (day2 > day1) return -1;
-	else if (day2 < day1) return 1;
-	else return 0;
-}
\ No newline at end of file
@@ -1,41 +1,111 @@
 /* file : items.h */
 #pragma once
+#include <stdint.h>
+#include <stdbool.h>
 #include "bloom.h"
 #include "skip_list.h"
+#include "arena.h"
+#include "date.h"
 
 typedef struct citizen_info * CitizenInfo;
 typedef struct virus_info * VirusInfo;
 typedef struct country_info * CountryInfo;
 
-CitizenInfo citizen_info_create(char * id, char * name, char * surname, int age, CountryInfo country);
-void citizen_info_destroy(CitizenInfo info);
+#define CITIZEN_KEY_DIGITS 18		// longest citizen id that can be keyed by an integer
+#define NO_CITIZEN_KEY 0			// key of an id that is not a string of (at most CITIZEN_KEY_DIGITS) digits
+#define AGE_GROUPS 4				// groups of ages reported by popStatusByAge
+#define EXPECTED_VACCINATED 1024	// least number of vaccinated persons the filter of a virus is sized for
+#define CITIZEN_INLINE_VIRUSES 2	// viruses of a citizen kept within its record, more are kept in an array of their own
+
+/* the status of a citizen for a virus : an entry of the per-citizen list of viruses */
+struct citizen_virus {
+	int virus_id;
+	Date date;					// date of vaccination (NO_DATE if not vaccinated)
+	bool vaccinated;
+};
+
+/* kind of the membership filter of the vaccinated persons of a virus (answers vaccineStatusBloom) */
+typedef enum {
+	FILTER_BLOOM,		// bloom filter (see bloom.h)
+	FILTER_CUCKOO,		// cuckoo filter of 16 bit fingerprints
+	FILTER_XOR			// xor filter of 8 bit fingerprints, built once the vaccinated persons are known (later ones go into a small cuckoo filter, until it is rebuilt)
+} FilterKind;
+
+/* integer key of a citizen id : the value of the digits of the id, prefixed with a 1 (so that leading zeros are kept).
+   Keys order ids the same way the skip lists always did : shorter ids first, ids of same length alphabetically */
+uint64_t citizen_key(const char * id);
+/* creates a citizen record (with its strings) as a single block of given arena, it is released along with the arena */
+CitizenInfo citizen_info_create(Arena arena, char * id, char * name, char * surname, int age, CountryInfo country);
+/* bytes the citizen record would take on the heap, with a separate malloc for the struct and each of its strings */
+size_t citizen_info_separate_size(CitizenInfo info);
 char * get_citizen_id(CitizenInfo info);
+uint64_t get_citizen_key(CitizenInfo info);
 char * get_citizen_name(CitizenInfo info);
 char * get_citizen_surname(CitizenInfo info);
 char * get_citizen_country(CitizenInfo info);
+CountryInfo get_citizen_country_info(CitizenInfo info);
 int get_citizen_age(CitizenInfo info);
 void citizen_info_print(CitizenInfo info);
+/* records the status of the citizen for the virus of given id (replacing the one recorded before, if any). Must follow the insertion into a skip list of the virus */
+void citizen_set_virus(CitizenInfo info, int virus_id, bool vaccinated, Date date);
+/* returns the viruses the citizen is in a skip list of, in ascending virus id, and sets their number */
+const struct citizen_virus * get_citizen_viruses(CitizenInfo info, int * num_of_viruses);
+/* releases what the citizen record holds outside of its arena (its array of viruses, if it has more than CITIZEN_INLINE_VIRUSES) */
+void citizen_info_release(CitizenInfo info);
 
 /*____________________________________________________________________________________________________*/
 
-VirusInfo virus_info_create(char * virus_name, unsigned int bloom_size, int max_level, float p);
+/* returns the name of given filter kind ("bloom", "cuckoo" or "xor") */
+const char * filter_kind_name(FilterKind kind);
+/* returns the filter kind of given name, -1 if there is no such kind */
+int filter_kind_parse(const char * name);
+/* creates a virus record, with a membership filter of given kind (given bloom filter, empty, if the kind is FILTER_BLOOM) */
+VirusInfo virus_info_create(char * virus_name, int virus_id, FilterKind filter_kind, Bloom bloom_filter, int max_level, float p);
 void virus_info_destroy(VirusInfo info);
 char * get_virus_name(VirusInfo info);
+int get_virus_id(VirusInfo info);
 Bloom get_bloom_filter(VirusInfo info);
+/* replaces the bloom filter of the virus with given empty one, into which the vaccinated persons of the virus are inserted */
+void set_bloom_filter(VirusInfo info, Bloom bloom_filter);
+FilterKind get_virus_filter_kind(VirusInfo info);
+/* inserts a vaccinated person into the membership filter of the virus. Must follow the insertion of the person into the vaccinated skip list */
+void virus_filter_insert(VirusInfo info, char * citizenID);
+/* checks if a person may be vaccinated for the virus, according to its membership filter */
+bool virus_filter_check(VirusInfo info, char * citizenID);
+/* same as virus_filter_check, for an id already hashed by hash_once */
+bool virus_filter_check_hash(VirusInfo info, char * citizenID, uint64_t hash);
+/* prefetches the part of the membership filter that a later check of given id (and its hash_once) reads */
+void virus_filter_prefetch(VirusInfo info, char * citizenID, uint64_t hash);
+/* makes room in a cuckoo filter of the virus for given number of vaccinated persons */
+void virus_filter_reserve(VirusInfo info, unsigned long num_of_keys);
+/* builds the xor filter of the virus from its vaccinated persons (and a cuckoo filter that misses some of them), e.g. after a bulk load or a restore */
+void virus_filter_seal(VirusInfo info);
+/* size in bytes of the membership filter of the virus */
+unsigned long virus_filter_memory(VirusInfo info);
 SkipList get_vacc_list(VirusInfo info);
 SkipList get_non_vacc_list(VirusInfo info);
+/* age group of an age : 0-20, 20-40, 40-60 and 60+ */
+int age_group(int age);
+/* adds change (1 or -1) to the live counters of the virus, for the country and age group of the citizen, 
+   in the vaccinated (with given date of vaccination) or the not vaccinated persons. Must follow every insertion into (and deletion from) the skip lists of the virus */
+void virus_count(VirusInfo info, CitizenInfo citizen, bool vaccinated, Date date, int change);
+/* number of vaccinated (or not vaccinated) persons of given country for the virus, of given age group (of all ages if group is -1) */
+int virus_counted(VirusInfo info, int country_id, bool vaccinated, int group);
+/* rebuilds all the counters (date indexes and projection) of the virus from its skip lists, e.g. after a bulk load, given the number of countries */
+void virus_recount(VirusInfo info, int num_of_countries);
+/* number of persons of given country vaccinated for the virus in [from, to], of given age group (of all ages if group is -1) */
+int virus_counted_in_range(VirusInfo info, int country_id, int group, Date from, Date to);
+/* number of persons of every country vaccinated for the virus in [from, to], per age group, counted in a single scan
+   (counts has AGE_GROUPS entries per country, those of a country start at country_id * AGE_GROUPS) */
+void virus_counted_in_range_all(VirusInfo info, Date from, Date to, int * counts, int num_of_countries);
 void virus_info_print(VirusInfo info);
 
 /*_____________________________________________________________________________________________________*/
 
-CountryInfo country_info_create(char * country_name);
+CountryInfo country_info_create(char * country_name, int country_id);
 void country_info_destroy(CountryInfo info);
 char * get_country_name(CountryInfo info);
+int get_country_id(CountryInfo info);
 void country_population_inc(CountryInfo info);
 unsigned long country_population(CountryInfo info);
 void country_info_print(CountryInfo info);
-
-/*_____________________________________________________________________________________________________*/
-
-int date_check(char * date);
-int date_cmp(char * date1, char * date2);
\ No newline at end of file
@@ -0,0 +1,599 @@
+/* file : loader.c */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "monitor.h"
+#include "loader.h"
+#include "wal.h"
+#include "date.h"
+#include <assert.h>
+
+#define CHUNKS_PER_THREAD 16			// file is split in more chunks than threads, so that work is balanced
+#define CHUNKS_IN_FLIGHT_PER_THREAD 2	// how many parsed chunks, per thread, may wait to be merged (bounds memory)
+#define MIN_CHUNK_SIZE (64 * 1024)
+#define NAME_CACHE_SIZE 64				// names of viruses and countries a parsing thread remembers, before it asks the shared table of names
+#define PREFETCH_DISTANCE 8				// the citizens index slot of a record is prefetched this many records before it is merged
+
+/* a record line already split into its fields, and what the parsing thread could resolve of it without the monitor */
+struct parsed_record {
+	char * fields[RECORD_FIELDS];
+	int num_of_fields;
+	uint64_t key;				// integer key of the id (see citizen_key)
+	Date date;					// day number of the date (NO_DATE if no date was given, or it is not a valid date)
+	int age;
+	int virus;					// ids of the names of the virus and the country (see struct names)
+	int country;
+};
+
+/* names of viruses (or countries) met by the parsing threads, each one with a dense id in order of first appearance */
+struct names {
+	char ** names;				// copies, so that they outlive the chunks they were found in
+	unsigned long * hashes;
+	int size;
+	int capacity;
+	pthread_mutex_t mutex;
+};
+
+/* names a parsing thread has already found an id for, by their hash (direct mapped) */
+struct name_cache {
+	unsigned long hash;
+	char * name;				// NULL if the entry is empty
+	int id;
+};
+
+/* a part of the mapped file, starting and ending on line boundaries */
+struct chunk {
+	char * start;
+	char * end;
+	struct parsed_record * records;		// records parsed from the chunk, in file order
+	long num_of_records;
+	char * last_line;					// copy of the last line of the file, if it has no newline
+	bool parsed;
+};
+
+/* state shared between parsing threads and the merging (main) thread */
+struct ingest {
+	struct chunk * chunks;
+	int num_of_chunks;
+	int next_chunk;				// next chunk to be parsed
+	int merged_chunks;			// number of chunks already merged into the monitor
+	int window;					// max number of chunks parsed ahead of the merge
+	pthread_mutex_t mutex;
+	pthread_cond_t parsed_cond;
+	pthread_cond_t merged_cond;
+	struct names viruses;		// names of viruses and countries, so that the merge finds their records by id instead of by name
+	struct names countries;
+	VirusInfo * known_viruses;	// records of the names of viruses and countries by name id, NULL until known (used by the merge only)
+	CountryInfo * known_countries;
+	int known_viruses_capacity;
+	int known_countries_capacity;
+};
+
+/* returns true if a line has neither the 7 fields of a not vaccinated person nor the 8 fields of a vaccinated one */
+static bool wrong_field_count(int num_of_fields)
+{
+	return num_of_fields < RECORD_FIELDS - 1 || num_of_fields > RECORD_FIELDS;
+}
+
+int loader_split_line(char * line, char ** fields, int max_fields)
+{
+	int num_of_fields = 0;
+	char * c = line;
+
+	while (*c != '\0')
+	{
+		while (*c == ' ' || *c == '\r')		// skip separators (runs of spaces behave like strtok)
+			*c++ = '\0';
+		if (*c == '\0')
+			break;
+
+		if (num_of_fields < max_fields)
+			fields[num_of_fields] = c;		// field starts here, it is a slice of the line itself
+		num_of_fields++;
+
+		while (*c != '\0' && *c != ' ' && *c != '\r')
+			c++;
+	}
+
+	return num_of_fields;
+}
+
+void loader_insert_fields(Monitor monitor, char ** fields, int num_of_fields)
+{
+	if (num_of_fields == 0)		// empty line, nothing to insert
+		return;
+
+	if (wrong_field_count(num_of_fields))
+	{
+		monitor_reject_fields(monitor, fields, (num_of_fields < RECORD_FIELDS) ? num_of_fields : RECORD_FIELDS);
+		return;
+	}
+
+	char * date = (num_of_fields == RECORD_FIELDS) ? fields[7] : NULL;
+	monitor_insert(monitor, fields[0], fields[1], fields[2], fields[3], atoi(fields[4]), fields[5], fields[6], date);
+}
+
+long loader_read_file(Monitor monitor, const char * path)
+{
+	FILE * file_ptr = fopen(path, "r");  /*open citizen records txt file , in read mode*/
+	if (file_ptr == NULL)
+	{
+		fprintf(stderr, "Error: loader_read_file -> fopen, could not open file\n");
+		return -1;
+	}
+
+	char * line = NULL;
+	size_t length = 0;
+	ssize_t read;
+	long num_of_lines = 0;
+	char * fields[RECORD_FIELDS];
+
+	while ((read = getline(&line, &length, file_ptr)) != -1)
+	{
+		if (read > 0 && line[read-1] == '\n')
+			line[read-1] = '\0';		// remove newline character from line read from file
+
+		loader_insert_fields(monitor, fields, loader_split_line(line, fields, RECORD_FIELDS));
+		num_of_lines++;
+	}
+
+	free(line);
+	fclose(file_ptr);
+	return num_of_lines;
+}
+
+long loader_mmap_file(Monitor monitor, const char * path)
+{
+	int fd = open(path, O_RDONLY);
+	if (fd == -1)
+	{
+		fprintf(stderr, "Error: loader_mmap_file -> open, could not open file\n");
+		return -1;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) == -1)
+	{
+		fprintf(stderr, "Error: loader_mmap_file -> fstat\n");
+		close(fd);
+		return -1;
+	}
+
+	size_t size = st.st_size;
+	if (size == 0)
+	{
+		close(fd);
+		return 0;
+	}
+
+	// private writable mapping : separators are overwritten with '\0' in place, the file itself is never modified
+	char * map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+	{
+		fprintf(stderr, "Error: loader_mmap_file -> mmap\n");
+		return -1;
+	}
+	madvise(map, size, MADV_SEQUENTIAL);
+
+	long num_of_lines = 0;
+	char * fields[RECORD_FIELDS];
+	char * cur = map;
+	char * end = map + size;
+
+	while (cur < end)
+	{
+		char * newline = memchr(cur, '\n', end - cur);
+		if (newline == NULL)
+		{
+			// last line has no newline, and there is no room to terminate it inside the mapping, so copy it
+			char * last_line = malloc(end - cur + 1);
+			if (last_line == NULL)
+				fprintf(stderr, "Error : loader_mmap_file -> malloc\n");
+			assert(last_line != NULL);
+			memcpy(last_line, cur, end - cur);
+			last_line[end - cur] = '\0';
+			loader_insert_fields(monitor, fields, loader_split_line(last_line, fields, RECORD_FIELDS));
+			free(last_line);
+			num_of_lines++;
+			break;
+		}
+
+		*newline = '\0';
+		loader_insert_fields(monitor, fields, loader_split_line(cur, fields, RECORD_FIELDS));
+		num_of_lines++;
+		cur = newline + 1;
+	}
+
+	munmap(map, size);
+	return num_of_lines;
+}
+
+/* returns the id of given name, using (and filling) the cache of the calling thread */
+static int name_id(struct names * names, struct name_cache * cache, char * name)
+{
+	unsigned long hash = hash_function((unsigned char *) name);
+	struct name_cache * entry = &cache[hash % NAME_CACHE_SIZE];
+	if (entry->name != NULL && entry->hash == hash && !strcmp(entry->name, name))
+		return entry->id;
+
+	pthread_mutex_lock(&names->mutex);
+	int id = 0;
+	while (id < names->size && (names->hashes[id] != hash || strcmp(names->names[id], name) != 0))
+		id++;
+	if (id == names->size)
+	{
+		if (names->size == names->capacity)
+		{
+			names->capacity = (names->capacity == 0) ? 16 : 2 * names->capacity;
+			names->names = realloc(names->names, names->capacity * sizeof(char *));
+			names->hashes = realloc(names->hashes, names->capacity * sizeof(unsigned long));
+			if (names->names == NULL || names->hashes == NULL)
+				fprintf(stderr, "Error : name_id -> realloc\n");
+			assert(names->names != NULL && names->hashes != NULL);
+		}
+		names->names[id] = strdup(name);
+		names->hashes[id] = hash;
+		names->size++;
+	}
+	entry->hash = hash;
+	entry->name = names->names[id];
+	entry->id = id;
+	pthread_mutex_unlock(&names->mutex);
+
+	return id;
+}
+
+/* parses what does not need the monitor (id key, date, age, ids of the names of virus and country), so that the merge only searches and inserts */
+static void resolve_record(struct ingest * ingest, struct name_cache * virus_cache, struct name_cache * country_cache, struct parsed_record * record)
+{
+	record->key = NO_CITIZEN_KEY;
+	if (wrong_field_count(record->num_of_fields))
+		return;
+
+	record->key = citizen_key(record->fields[0]);
+	record->date = (record->num_of_fields == RECORD_FIELDS) ? date_parse(record->fields[7]) : NO_DATE;
+	record->age = atoi(record->fields[4]);
+	record->virus = name_id(&ingest->viruses, virus_cache, record->fields[5]);
+	record->country = name_id(&ingest->countries, country_cache, record->fields[3]);
+}
+
+static void parse_chunk(struct ingest * ingest, struct name_cache * virus_cache, struct name_cache * country_cache, struct chunk * chunk)
+{
+	long capacity = 1024;
+	chunk->records = malloc(capacity * sizeof(struct parsed_record));
+	if (chunk->records == NULL)
+		fprintf(stderr, "Error : parse_chunk -> malloc\n");
+	assert(chunk->records != NULL);
+	chunk->num_of_records = 0;
+	chunk->last_line = NULL;
+
+	char * cur = chunk->start;
+	while (cur < chunk->end)
+	{
+		char * line = cur;
+		char * newline = memchr(cur, '\n', chunk->end - cur);
+		if (newline == NULL)
+		{
+			// last line of file has no newline, copy it so that it can be terminated
+			chunk->last_line = malloc(chunk->end - cur + 1);
+			if (chunk->last_line == NULL)
+				fprintf(stderr, "Error : parse_chunk -> malloc\n");
+			assert(chunk->last_line != NULL);
+			memcpy(chunk->last_line, cur, chunk->end - cur);
+			chunk->last_line[chunk->end - cur] = '\0';
+			line = chunk->last_line;
+			cur = chunk->end;
+		}
+		else
+		{
+			*newline = '\0';
+			cur = newline + 1;
+		}
+
+		if (chunk->num_of_records == capacity)
+		{
+			capacity *= 2;
+			chunk->records = realloc(chunk->records, capacity * sizeof(struct parsed_record));
+			if (chunk->records == NULL)
+				fprintf(stderr, "Error : parse_chunk -> realloc\n");
+			assert(chunk->records != NULL);
+		}
+		struct parsed_record * record = &chunk->records[chunk->num_of_records++];
+		record->num_of_fields = loader_split_line(line, record->fields, RECORD_FIELDS);
+		resolve_record(ingest, virus_cache, country_cache, record);
+	}
+}
+
+static void * parse_thread(void * arg)
+{
+	struct ingest * ingest = arg;
+	struct name_cache virus_cache[NAME_CACHE_SIZE] = { { 0 } };
+	struct name_cache country_cache[NAME_CACHE_SIZE] = { { 0 } };
+
+	while (true)
+	{
+		pthread_mutex_lock(&ingest->mutex);
+		// do not run too far ahead of the merge, parsed chunks wait in memory until they are merged
+		while (ingest->next_chunk < ingest->num_of_chunks && ingest->next_chunk >= ingest->merged_chunks + ingest->window)
+			pthread_cond_wait(&ingest->merged_cond, &ingest->mutex);
+
+		if (ingest->next_chunk >= ingest->num_of_chunks)
+		{
+			pthread_mutex_unlock(&ingest->mutex);
+			return NULL;
+		}
+		struct chunk * chunk = &ingest->chunks[ingest->next_chunk++];
+		pthread_mutex_unlock(&ingest->mutex);
+
+		parse_chunk(ingest, virus_cache, country_cache, chunk);
+
+		pthread_mutex_lock(&ingest->mutex);
+		chunk->parsed = true;
+		pthread_cond_broadcast(&ingest->parsed_cond);
+		pthread_mutex_unlock(&ingest->mutex);
+	}
+}
+
+/* makes room in given array of known records (of given element size) for all the names met so far, the new entries are NULL */
+static void * known_reserve(void * known, int * capacity, struct names * names, size_t element_size)
+{
+	pthread_mutex_lock(&names->mutex);
+	int size = names->size;
+	pthread_mutex_unlock(&names->mutex);
+	if (size <= *capacity)
+		return known;
+
+	known = realloc(known, size * element_size);
+	if (known == NULL)
+		fprintf(stderr, "Error : known_reserve -> realloc\n");
+	assert(known != NULL);
+	memset((char *) known + *capacity * element_size, 0, (size - *capacity) * element_size);
+	*capacity = size;
+	return known;
+}
+
+/* inserts the records of a parsed chunk into the monitor, in file order */
+static void merge_chunk(Monitor monitor, struct ingest * ingest, struct chunk * chunk)
+{
+	ingest->known_viruses = known_reserve(ingest->known_viruses, &ingest->known_viruses_capacity, &ingest->viruses, sizeof(VirusInfo));
+	ingest->known_countries = known_reserve(ingest->known_countries, &ingest->known_countries_capacity, &ingest->countries, sizeof(CountryInfo));
+	HT citizens = get_citizens_index(monitor);
+
+	for (long i = 0; i < chunk->num_of_records; i++)
+	{
+		// the search of the citizen is what is left of a record for the merge, so its slot is fetched ahead
+		if (i + PREFETCH_DISTANCE < chunk->num_of_records)
+			hash_prefetch_citizen(citizens, chunk->records[i + PREFETCH_DISTANCE].key);
+
+		struct parsed_record * record = &chunk->records[i];
+		char ** fields = record->fields;
+		if (record->num_of_fields == 0 || wrong_field_count(record->num_of_fields))
+		{
+			loader_insert_fields(monitor, fields, record->num_of_fields);		// empty line, or reported as invalid
+			continue;
+		}
+
+		char * date = (record->num_of_fields == RECORD_FIELDS) ? fields[7] : NULL;
+		monitor_insert_resolved(monitor, record->key, record->date, &ingest->known_viruses[record->virus], &ingest->known_countries[record->country],
+			fields[0], fields[1], fields[2], fields[3], record->age, fields[5], fields[6], date);
+	}
+}
+
+static void names_destroy(struct names * names)
+{
+	for (int i = 0; i < names->size; i++)
+		free(names->names[i]);
+	free(names->names);
+	free(names->hashes);
+	pthread_mutex_destroy(&names->mutex);
+}
+
+long loader_parallel_file(Monitor monitor, const char * path, int num_of_threads)
+{
+	if (num_of_threads <= 1)
+		return loader_mmap_file(monitor, path);
+
+	int fd = open(path, O_RDONLY);
+	if (fd == -1)
+	{
+		fprintf(stderr, "Error: loader_parallel_file -> open, could not open file\n");
+		return -1;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) == -1)
+	{
+		fprintf(stderr, "Error: loader_parallel_file -> fstat\n");
+		close(fd);
+		return -1;
+	}
+
+	size_t size = st.st_size;
+	if (size == 0)
+	{
+		close(fd);
+		return 0;
+	}
+
+	char * map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+	{
+		fprintf(stderr, "Error: loader_parallel_file -> mmap\n");
+		return -1;
+	}
+
+	// split the mapping into chunks, each chunk ends right after a newline (or at the end of file)
+	struct ingest ingest;
+	size_t chunk_size = size / ((size_t) num_of_threads * CHUNKS_PER_THREAD) + 1;
+	if (chunk_size < MIN_CHUNK_SIZE)
+		chunk_size = MIN_CHUNK_SIZE;
+
+	ingest.chunks = malloc((size / chunk_size + 1) * sizeof(struct chunk));
+	if (ingest.chunks == NULL)
+		fprintf(stderr, "Error : loader_parallel_file -> malloc\n");
+	assert(ingest.chunks != NULL);
+	ingest.num_of_chunks = 0;
+	char * cur = map;
+	char * end = map + size;
+	while (cur < end)
+	{
+		char * chunk_end = cur + chunk_size;
+		if (chunk_end >= end)
+			chunk_end = end;
+		else
+		{
+			char * newline = memchr(chunk_end, '\n', end - chunk_end);
+			chunk_end = (newline == NULL) ? end : newline + 1;
+		}
+
+		struct chunk * chunk = &ingest.chunks[ingest.num_of_chunks++];
+		chunk->start = cur;
+		chunk->end = chunk_end;
+		chunk->parsed = false;
+		cur = chunk_end;
+	}
+
+	ingest.next_chunk = 0;
+	ingest.merged_chunks = 0;
+	ingest.window = num_of_threads * CHUNKS_IN_FLIGHT_PER_THREAD;
+	pthread_mutex_init(&ingest.mutex, NULL);
+	pthread_cond_init(&ingest.parsed_cond, NULL);
+	pthread_cond_init(&ingest.merged_cond, NULL);
+	memset(&ingest.viruses, 0, sizeof(struct names));
+	memset(&ingest.countries, 0, sizeof(struct names));
+	pthread_mutex_init(&ingest.viruses.mutex, NULL);
+	pthread_mutex_init(&ingest.countries.mutex, NULL);
+	ingest.known_viruses = NULL;
+	ingest.known_countries = NULL;
+	ingest.known_viruses_capacity = 0;
+	ingest.known_countries_capacity = 0;
+
+	pthread_t threads[num_of_threads];
+	for (int i = 0; i < num_of_threads; i++)
+		pthread_create(&threads[i], NULL, parse_thread, &ingest);
+
+	// merge chunks into the monitor strictly in file order, so that the first record of a citizen
+	// is the one kept, and INCONSISTENT / DUPLICATE records are reported exactly as in a sequential load
+	long num_of_lines = 0;
+	for (int i = 0; i < ingest.num_of_chunks; i++)
+	{
+		struct chunk * chunk = &ingest.chunks[i];
+
+		pthread_mutex_lock(&ingest.mutex);
+		while (!chunk->parsed)
+			pthread_cond_wait(&ingest.parsed_cond, &ingest.mutex);
+		pthread_mutex_unlock(&ingest.mutex);
+
+		merge_chunk(monitor, &ingest, chunk);
+		num_of_lines += chunk->num_of_records;
+
+		free(chunk->records);
+		free(chunk->last_line);
+
+		pthread_mutex_lock(&ingest.mutex);
+		ingest.merged_chunks++;
+		pthread_cond_broadcast(&ingest.merged_cond);
+		pthread_mutex_unlock(&ingest.mutex);
+	}
+
+	for (int i = 0; i < num_of_threads; i++)
+		pthread_join(threads[i], NULL);
+
+	pthread_mutex_destroy(&ingest.mutex);
+	pthread_cond_destroy(&ingest.parsed_cond);
+	pthread_cond_destroy(&ingest.merged_cond);
+	names_destroy(&ingest.viruses);
+	names_destroy(&ingest.countries);
+	free(ingest.known_viruses);
+	free(ingest.known_countries);
+	free(ingest.chunks);
+	munmap(map, size);
+
+	return num_of_lines;
+}
+
+/* applies a single logged mutation, split into its fields (first field is the tag of the mutation) */
+static bool replay_fields(Monitor monitor, char ** fields, int num_of_fields)
+{
+	if (num_of_fields >= 1 && !strcmp(fields[0], WAL_INSERT) && (num_of_fields == RECORD_FIELDS || num_of_fields == RECORD_FIELDS + 1))
+	{
+		char * date = (num_of_fields == RECORD_FIELDS + 1) ? fields[8] : NULL;
+		insertCitizenRecord(monitor, fields[1], fields[2], fields[3], fields[4], atoi(fields[5]), fields[6], fields[7], date);
+		return true;
+	}
+
+	if (num_of_fields == RECORD_FIELDS && !strcmp(fields[0], WAL_VACCINATE) && date_parse(fields[7]) != NO_DATE)
+	{
+		vaccinateOnDate(monitor, fields[1], fields[2], fields[3], fields[4], atoi(fields[5]), fields[6], date_parse(fields[7]));
+		return true;
+	}
+
+	return false;
+}
+
+long loader_replay_wal(Monitor monitor, const char * path)
+{
+	int fd = open(path, O_RDONLY);
+	if (fd == -1)
+		return 0;			// no log yet, nothing to replay
+
+	struct stat st;
+	if (fstat(fd, &st) == -1)
+	{
+		fprintf(stderr, "Error: loader_replay_wal -> fstat\n");
+		close(fd);
+		return -1;
+	}
+
+	size_t size = st.st_size;
+	if (size == 0)
+	{
+		close(fd);
+		return 0;
+	}
+
+	char * map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+	{
+		fprintf(stderr, "Error: loader_replay_wal -> mmap\n");
+		return -1;
+	}
+	madvise(map, size, MADV_SEQUENTIAL);
+
+	long num_of_records = 0;
+	char * fields[RECORD_FIELDS + 1];
+	char * cur = map;
+	char * end = map + size;
+
+	monitor_set_quiet(monitor, true);		// replayed mutations were already reported when they were first applied
+	while (cur < end)
+	{
+		char * newline = memchr(cur, '\n', end - cur);
+		if (newline == NULL)		// a partially written last record was never applied, so it is ignored
+			break;
+
+		*newline = '\0';
+		int num_of_fields = loader_split_line(cur, fields, RECORD_FIELDS + 1);
+		if (num_of_fields > 0)
+		{
+			if (replay_fields(monitor, fields, num_of_fields))
+				num_of_records++;
+			else
+				fprintf(stderr, "Error: loader_replay_wal -> unknown log record skipped\n");
+		}
+		cur = newline + 1;
+	}
+	monitor_set_quiet(monitor, false);
+
+	munmap(map, size);
+	return num_of_records;
+}
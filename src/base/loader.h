@@ -0,0 +1,18 @@
+/* file : loader.h */
+#pragma once
+#include "monitor.h"
+
+#define RECORD_FIELDS 8		// id, name, surname, country, age, virus, vaccinated, date
+
+/* splits a record line in place (separators are overwritten with '\0'), returns the number of fields found */
+int loader_split_line(char * line, char ** fields, int max_fields);
+/* inserts an already split record line into the monitor */
+void loader_insert_fields(Monitor monitor, char ** fields, int num_of_fields);
+/* reads citizen records file line by line and inserts its records into the monitor, returns number of lines read (-1 on error) */
+long loader_read_file(Monitor monitor, const char * path);
+/* maps citizen records file into memory and inserts its records into the monitor, tokens are sliced in place from the mapping */
+long loader_mmap_file(Monitor monitor, const char * path);
+/* maps citizen records file, parses chunks of it in parallel with given number of threads, and merges them into the monitor in file order */
+long loader_parallel_file(Monitor monitor, const char * path, int num_of_threads);
+/* applies all mutations of a write-ahead log on top of the monitor, returns number of mutations replayed (-1 on error) */
+long loader_replay_wal(Monitor monitor, const char * path);
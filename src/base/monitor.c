@@ -2,22 +2,75 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <time.h>
 #include "monitor.h"
 #include "skip_list.h"
 #include "bloom.h"
+#include "cuckoo.h"
+#include "xor_filter.h"
+#include "sliced_bloom.h"
 #include "hash.h"
 #include "list.h"
 #include "items.h"
-#include "time.h"
+#include "arena.h"
+#include "wal.h"
 #include <assert.h>
 
+#define CITIZENS_SLAB_SIZE (4 * 1024 * 1024)		// citizen records are allocated from slabs of this size
+#define CITIZEN_LOCKS 64							// locks of the lists of viruses of citizens during a bulk load, a citizen is locked by its key modulo this
+#define BATCH_BLOCK 256								// ids of a batch are hashed and prefetched this many at a time, before any of them is resolved
+#define BATCH_ID_SIZE 32							// longest id of a batch (a longer one is cut, and found nowhere)
+
+/* a record of a bulk load, waiting to be inserted into the skip lists of its virus */
+struct pending_record {
+	CitizenInfo citizen;
+	char * vacc;				// "YES", "NO" or a copy of any other given string
+	Date date;					// day number of the given date (NO_DATE if no date was given)
+	long seq;					// position of the record in the input
+};
+
+/* deferred records of a single virus, in input order */
+struct pending_list {
+	struct pending_record * records;
+	long size;
+	long capacity;
+};
+
+/* a rejected record of a bulk load, its message is printed when the load ends */
+struct rejection {
+	long seq;
+	char * message;
+};
+
 struct monitor {
 	HT citizens_info;
+	Arena citizens_arena;				// memory of all citizen records
 	HT viruses_info;
 	HT countries_info;
 	unsigned int bloom_size;
+	BloomLayout bloom_layout;			// layout of the bloom filters of viruses created from now on
+	double bloom_fpr;					// target false positive rate of the bloom filters (0 if they are all of bloom_size)
+	bool bloom_scalable;				// if true, bloom filters (of a target false positive rate) grow with their keys
+	FilterKind filter_kind;				// kind of the membership filters of viruses created from now on
+	SlicedBloom sliced_bloom;			// bit-sliced bloom filter of the vaccinated persons of all viruses, a set per virus id (NULL if not kept)
+	unsigned long sliced_capacity;		// number of vaccinated persons of a virus the bit-sliced bloom filter is sized for
 	int max_level;
 	float p;
+	bool bulk;							// true while a bulk load is in progress
+	long bulk_seq;						// number of records given to monitor_insert so far
+	struct pending_list * pending;		// deferred records of the bulk load, indexed by virus id
+	int pending_capacity;
+	struct rejection * rejections;		// rejected records of the bulk load
+	long num_of_rejections;
+	long rejections_capacity;
+	pthread_mutex_t rejections_mutex;
+	pthread_mutex_t citizen_locks[CITIZEN_LOCKS];
+	Wal wal;							// write-ahead log of insertCitizenRecord / vaccinateNow (NULL if not logging)
+	bool quiet;							// if true, successful mutations are not reported (used while replaying a log)
+	pthread_rwlock_t lock;				// held shared by queries running in parallel, exclusively by anything that modifies the monitor meanwhile
 };
 
 Monitor monitor_create(unsigned int bloom_size, int max_level, float p)
@@ -28,16 +81,269 @@ Monitor monitor_create(unsigned int bloom_size, int max_level, float p)
 	assert(monitor != NULL);
 
 	monitor->citizens_info = hash_create(100, 0);
+	monitor->citizens_arena = arena_create(CITIZENS_SLAB_SIZE);
 	monitor->viruses_info = hash_create(10, 1);
 	monitor->countries_info = hash_create(10, 2);
 
 	monitor->bloom_size = bloom_size;
+	monitor->bloom_layout = BLOOM_CLASSIC;
+	monitor->bloom_fpr = 0;
+	monitor->bloom_scalable = false;
+	monitor->filter_kind = FILTER_BLOOM;
+	monitor->sliced_bloom = NULL;
+	monitor->sliced_capacity = 0;
 	monitor->max_level = max_level;
 	monitor->p = p;
 
+	monitor->bulk = false;
+	monitor->bulk_seq = 0;
+	monitor->pending = NULL;
+	monitor->pending_capacity = 0;
+	monitor->rejections = NULL;
+	monitor->num_of_rejections = 0;
+	monitor->rejections_capacity = 0;
+	pthread_mutex_init(&monitor->rejections_mutex, NULL);
+	pthread_rwlock_init(&monitor->lock, NULL);
+	for (int i = 0; i < CITIZEN_LOCKS; i++)
+		pthread_mutex_init(&monitor->citizen_locks[i], NULL);
+	monitor->wal = NULL;
+	monitor->quiet = false;
+
 	return monitor;
 }
 
+HT get_citizens_index(Monitor monitor)
+{
+	return monitor->citizens_info;
+}
+
+Arena get_citizens_arena(Monitor monitor)
+{
+	return monitor->citizens_arena;
+}
+
+HT get_viruses_index(Monitor monitor)
+{
+	return monitor->viruses_info;
+}
+
+HT get_countries_index(Monitor monitor)
+{
+	return monitor->countries_info;
+}
+
+unsigned int get_bloom_size(Monitor monitor)
+{
+	return monitor->bloom_size;
+}
+
+void set_bloom_size(Monitor monitor, unsigned int bloom_size)
+{
+	monitor->bloom_size = bloom_size;
+}
+
+BloomLayout get_bloom_layout(Monitor monitor)
+{
+	return monitor->bloom_layout;
+}
+
+void set_bloom_layout(Monitor monitor, BloomLayout bloom_layout)
+{
+	monitor->bloom_layout = bloom_layout;
+}
+
+double get_bloom_fpr(Monitor monitor)
+{
+	return monitor->bloom_fpr;
+}
+
+void set_bloom_fpr(Monitor monitor, double fpr)
+{
+	monitor->bloom_fpr = fpr;
+}
+
+bool get_bloom_scalable(Monitor monitor)
+{
+	return monitor->bloom_scalable;
+}
+
+void set_bloom_scalable(Monitor monitor, bool scalable)
+{
+	monitor->bloom_scalable = scalable;
+}
+
+FilterKind get_filter_kind(Monitor monitor)
+{
+	return monitor->filter_kind;
+}
+
+void set_filter_kind(Monitor monitor, FilterKind filter_kind)
+{
+	monitor->filter_kind = filter_kind;
+}
+
+/* creates an empty bloom filter of given layout for a virus of given number of vaccinated persons : of the bloom size of the monitor, or sized from its target false positive rate */
+static Bloom new_bloom_filter(Monitor monitor, unsigned long num_of_keys, BloomLayout layout)
+{
+	if (monitor->bloom_fpr == 0)
+		return bloom_create(monitor->bloom_size, K, layout);
+
+	if (num_of_keys < EXPECTED_VACCINATED)
+		num_of_keys = EXPECTED_VACCINATED;
+	if (monitor->bloom_scalable)
+		return bloom_create_scalable(num_of_keys, monitor->bloom_fpr, layout);
+
+	unsigned int bloom_size;
+	int num_of_hashes;
+	bloom_dimensions(num_of_keys, monitor->bloom_fpr, &bloom_size, &num_of_hashes);
+	return bloom_create(bloom_size, num_of_hashes, layout);
+}
+
+/* with a target false positive rate, replaces the bloom filter of given virus if it is too small for given number of vaccinated persons */
+static void size_bloom_filter(Monitor monitor, VirusInfo virus_info, unsigned long num_of_keys)
+{
+	if (get_virus_filter_kind(virus_info) != FILTER_BLOOM)		// other filters are sized by their number of keys alone
+	{
+		virus_filter_reserve(virus_info, num_of_keys);
+		return;
+	}
+	if (monitor->bloom_fpr == 0)
+		return;
+
+	Bloom bloom = get_bloom_filter(virus_info);
+	if (monitor->bloom_scalable && bloom_capacity(bloom) != 0)
+	{
+		// a scalable filter grows by itself, it is only replaced while still empty, so that it starts with a single sub-filter of all the keys of the bulk load
+		if (!skip_list_is_empty(get_vacc_list(virus_info)) || bloom_capacity(bloom) >= num_of_keys)
+			return;
+	}
+	else if (!monitor->bloom_scalable && bloom_capacity(bloom) == 0)
+	{
+		unsigned int bloom_size, current_size;
+		int num_of_hashes;
+		bloom_dimensions((num_of_keys < EXPECTED_VACCINATED) ? EXPECTED_VACCINATED : num_of_keys, monitor->bloom_fpr, &bloom_size, &num_of_hashes);
+		bloom_bits(bloom, &current_size);
+		if (current_size >= bloom_size && bloom_hashes(bloom) == num_of_hashes)
+			return;
+	}
+	set_bloom_filter(virus_info, new_bloom_filter(monitor, num_of_keys, bloom_layout(get_bloom_filter(virus_info))));
+}
+
+/* replaces the bit-sliced bloom filter with one of a set per virus, sized for the virus of the most vaccinated persons (at least given number of them),
+   at the target false positive rate of the monitor (1% if there is none), and inserts the vaccinated persons of all viruses into it */
+static void rebuild_sliced_bloom(Monitor monitor, unsigned long num_of_keys)
+{
+	struct hash_cursor cursor;
+	VirusInfo virus_info;
+	hash_cursor_begin(monitor->viruses_info, &cursor);
+	while ((virus_info = hash_cursor_next(&cursor)) != NULL)
+	{
+		if ((unsigned long) skip_list_size(get_vacc_list(virus_info)) > num_of_keys)
+			num_of_keys = skip_list_size(get_vacc_list(virus_info));
+	}
+	hash_cursor_end(&cursor);
+	if (num_of_keys < EXPECTED_VACCINATED)
+		num_of_keys = EXPECTED_VACCINATED;
+
+	unsigned int bloom_size;
+	int num_of_hashes;
+	bloom_dimensions(num_of_keys, (monitor->bloom_fpr != 0) ? monitor->bloom_fpr : 0.01, &bloom_size, &num_of_hashes);
+	if (monitor->sliced_bloom != NULL)
+		sliced_bloom_destroy(monitor->sliced_bloom);
+	monitor->sliced_bloom = sliced_bloom_create(8 * (unsigned long) bloom_size, num_of_hashes, hash_size(monitor->viruses_info));
+	monitor->sliced_capacity = num_of_keys;
+
+	hash_cursor_begin(monitor->viruses_info, &cursor);
+	while ((virus_info = hash_cursor_next(&cursor)) != NULL)
+	{
+		// the vaccinated persons of the virus are read off level 0 of its skip list
+		struct skip_list_cursor person;
+		CitizenInfo citizen_info;
+		skip_list_cursor_begin(get_vacc_list(virus_info), 0, &person);
+		while ((citizen_info = skip_list_cursor_next(&person, NULL)) != NULL)
+			sliced_bloom_insert(monitor->sliced_bloom, get_virus_id(virus_info), hash_once((unsigned char *) get_citizen_id(citizen_info)));
+		skip_list_cursor_end(&person);
+	}
+	hash_cursor_end(&cursor);
+}
+
+/* inserts a vaccinated person into the bit-sliced bloom filter (if it is kept). Must follow the insertion of the person into the vaccinated skip list of the virus,
+   as the filter is built again (larger) when the virus has more vaccinated persons than it is sized for, or a new virus does not fit into its rows */
+static void sliced_bloom_insert_person(Monitor monitor, VirusInfo virus_info, char * citizenID)
+{
+	if (monitor->sliced_bloom == NULL)
+		return;
+	if (get_virus_id(virus_info) >= sliced_bloom_sets(monitor->sliced_bloom))
+		rebuild_sliced_bloom(monitor, monitor->sliced_capacity);
+	else if ((unsigned long) skip_list_size(get_vacc_list(virus_info)) > monitor->sliced_capacity)
+		rebuild_sliced_bloom(monitor, 2 * monitor->sliced_capacity);
+	else
+		sliced_bloom_insert(monitor->sliced_bloom, get_virus_id(virus_info), hash_once((unsigned char *) citizenID));
+}
+
+bool get_bloom_sliced(Monitor monitor)
+{
+	return monitor->sliced_bloom != NULL;
+}
+
+void set_bloom_sliced(Monitor monitor, bool sliced)
+{
+	if (sliced && monitor->sliced_bloom == NULL)
+		rebuild_sliced_bloom(monitor, 0);
+	else if (!sliced && monitor->sliced_bloom != NULL)
+	{
+		sliced_bloom_destroy(monitor->sliced_bloom);
+		monitor->sliced_bloom = NULL;
+	}
+}
+
+/* creates a virus record, with a membership filter of the kind of the monitor */
+static VirusInfo new_virus(Monitor monitor, char * virusName)
+{
+	Bloom bloom_filter = (monitor->filter_kind == FILTER_BLOOM) ? new_bloom_filter(monitor, 0, monitor->bloom_layout) : NULL;
+	return virus_info_create(virusName, hash_size(monitor->viruses_info), monitor->filter_kind, bloom_filter, monitor->max_level, monitor->p);
+}
+
+int get_max_level(Monitor monitor)
+{
+	return monitor->max_level;
+}
+
+float get_level_prob(Monitor monitor)
+{
+	return monitor->p;
+}
+
+void monitor_set_wal(Monitor monitor, Wal wal)
+{
+	monitor->wal = wal;
+}
+
+Wal get_wal(Monitor monitor)
+{
+	return monitor->wal;
+}
+
+void monitor_set_quiet(Monitor monitor, bool quiet)
+{
+	monitor->quiet = quiet;
+}
+
+void monitor_read_lock(Monitor monitor)
+{
+	pthread_rwlock_rdlock(&monitor->lock);
+}
+
+void monitor_write_lock(Monitor monitor)
+{
+	pthread_rwlock_wrlock(&monitor->lock);
+}
+
+void monitor_unlock(Monitor monitor)
+{
+	pthread_rwlock_unlock(&monitor->lock);
+}
+
 void monitor_destroy(Monitor monitor)
 {
 	if (monitor == NULL)
@@ -45,12 +351,153 @@ void monitor_destroy(Monitor monitor)
 	assert(monitor != NULL);
 
 	hash_destroy(monitor->countries_info);
+	for (int i = 0; i < hash_size(monitor->citizens_info); i++)
+		citizen_info_release(hash_entry(monitor->citizens_info, i));
 	hash_destroy(monitor->citizens_info);
 	hash_destroy(monitor->viruses_info);
-
+	arena_destroy(monitor->citizens_arena);		// all citizen records are released at once, slab by slab
+	if (monitor->sliced_bloom != NULL)
+		sliced_bloom_destroy(monitor->sliced_bloom);
+
+	pthread_mutex_destroy(&monitor->rejections_mutex);
+	pthread_rwlock_destroy(&monitor->lock);
+	for (int i = 0; i < CITIZEN_LOCKS; i++)
+		pthread_mutex_destroy(&monitor->citizen_locks[i]);
 	free(monitor);
 }
 
+/* records the status of a citizen for a virus in its list of viruses. During a bulk load viruses are built by different threads,
+   and a citizen may be in records of several of them, so its list is locked meanwhile */
+static void set_citizen_virus(Monitor monitor, CitizenInfo citizen_info, VirusInfo virus_info, bool vaccinated, Date date)
+{
+	if (!monitor->bulk)
+	{
+		citizen_set_virus(citizen_info, get_virus_id(virus_info), vaccinated, date);
+		return;
+	}
+
+	pthread_mutex_t * lock = &monitor->citizen_locks[get_citizen_key(citizen_info) % CITIZEN_LOCKS];
+	pthread_mutex_lock(lock);
+	citizen_set_virus(citizen_info, get_virus_id(virus_info), vaccinated, date);
+	pthread_mutex_unlock(lock);
+}
+
+/* a record is of invalid form if vaccinated == "YES" but no date is given, or vaccinated == "NO" but a date is given */
+static bool invalid_form(char * vacc, Date date)
+{
+	return ( !strcmp(vacc, "YES") && date == NO_DATE) || (!strcmp(vacc, "NO") && date != NO_DATE);
+}
+
+/* keeps the message of a rejected record of a bulk load, to be printed in input order when the load ends */
+static void keep_rejection(Monitor monitor, long seq, char * message)
+{
+	pthread_mutex_lock(&monitor->rejections_mutex);		// skip lists of different viruses are built by different threads
+	if (monitor->num_of_rejections == monitor->rejections_capacity)
+	{
+		monitor->rejections_capacity = (monitor->rejections_capacity == 0) ? 64 : 2 * monitor->rejections_capacity;
+		monitor->rejections = realloc(monitor->rejections, monitor->rejections_capacity * sizeof(struct rejection));
+		if (monitor->rejections == NULL)
+			fprintf(stderr, "Error : keep_rejection -> realloc\n");
+		assert(monitor->rejections != NULL);
+	}
+	monitor->rejections[monitor->num_of_rejections].seq = seq;
+	monitor->rejections[monitor->num_of_rejections].message = message;
+	monitor->num_of_rejections++;
+	pthread_mutex_unlock(&monitor->rejections_mutex);
+}
+
+/* reports a rejected record of the input file. During a bulk load the message is kept, and printed in input order when the load ends */
+static void reject_record(Monitor monitor, long seq, char * citizenID, char * firstName, char * lastName, char * country, int age, char * virusName, char * vacc, char * date, char * reason)
+{
+	const char * format = "ERROR IN RECORD : %s %s %s %s %d %s %s %s\n%s\n\n";
+
+	if (!monitor->bulk)
+	{
+		printf(format, citizenID, firstName, lastName, country, age, virusName, vacc, (date == NULL) ? "" : date, reason);
+		return;
+	}
+
+	int length = snprintf(NULL, 0, format, citizenID, firstName, lastName, country, age, virusName, vacc, (date == NULL) ? "" : date, reason);
+	char * message = malloc(length + 1);
+	if (message == NULL)
+		fprintf(stderr, "Error : reject_record -> malloc\n");
+	assert(message != NULL);
+	snprintf(message, length + 1, format, citizenID, firstName, lastName, country, age, virusName, vacc, (date == NULL) ? "" : date, reason);
+	keep_rejection(monitor, seq, message);
+}
+
+void monitor_reject_fields(Monitor monitor, char ** fields, int num_of_fields)
+{
+	if (monitor == NULL)
+		fprintf(stderr, "Error : monitor_reject_fields -> monitor is NULL\n");
+	assert(monitor != NULL);
+
+	long seq = monitor->bulk_seq++;
+
+	// the fields are printed as given, each one followed by a space
+	size_t length = strlen("ERROR IN RECORD : ") + strlen("\nINVALID INPUT DATA FORM\n\n") + 1;
+	for (int i = 0; i < num_of_fields; i++)
+		length += strlen(fields[i]) + 1;
+	char * message = malloc(length);
+	if (message == NULL)
+		fprintf(stderr, "Error : monitor_reject_fields -> malloc\n");
+	assert(message != NULL);
+
+	strcpy(message, "ERROR IN RECORD : ");
+	for (int i = 0; i < num_of_fields; i++)
+	{
+		strcat(message, fields[i]);
+		strcat(message, " ");
+	}
+	strcat(message, "\nINVALID INPUT DATA FORM\n\n");
+
+	if (!monitor->bulk)
+	{
+		fputs(message, stdout);
+		free(message);
+		return;
+	}
+	keep_rejection(monitor, seq, message);
+}
+
+/* defers the insertion of a record into the skip lists and bloom filter of its virus, until the bulk load ends */
+static void pending_append(Monitor monitor, VirusInfo virus_info, CitizenInfo citizen_info, char * vacc, Date date, long seq)
+{
+	int virus_id = get_virus_id(virus_info);
+	if (virus_id >= monitor->pending_capacity)
+	{
+		int prev_capacity = monitor->pending_capacity;
+		monitor->pending_capacity = 2 * (virus_id + 1);
+		monitor->pending = realloc(monitor->pending, monitor->pending_capacity * sizeof(struct pending_list));
+		if (monitor->pending == NULL)
+			fprintf(stderr, "Error : pending_append -> realloc\n");
+		assert(monitor->pending != NULL);
+		memset(&monitor->pending[prev_capacity], 0, (monitor->pending_capacity - prev_capacity) * sizeof(struct pending_list));
+	}
+
+	struct pending_list * list = &monitor->pending[virus_id];
+	if (list->size == list->capacity)
+	{
+		list->capacity = (list->capacity == 0) ? 1024 : 2 * list->capacity;
+		list->records = realloc(list->records, list->capacity * sizeof(struct pending_record));
+		if (list->records == NULL)
+			fprintf(stderr, "Error : pending_append -> realloc\n");
+		assert(list->records != NULL);
+	}
+
+	struct pending_record * record = &list->records[list->size++];
+	record->citizen = citizen_info;
+	// the given vaccinated string belongs to the caller's line buffer, so keep a copy of it
+	if (!strcmp(vacc, "YES"))
+		record->vacc = "YES";
+	else if (!strcmp(vacc, "NO"))
+		record->vacc = "NO";
+	else
+		record->vacc = strdup(vacc);
+	record->date = date;
+	record->seq = seq;
+}
+
 void monitor_insert(Monitor monitor, char * citizenID , char * firstName, char * lastName, char * country, unsigned int age, char * virusName, char * vacc, char * date)
 {
 
@@ -58,12 +505,44 @@ void monitor_insert(Monitor monitor, char * citizenID , char * firstName, char *
 		fprintf(stderr, "Error : monitor_insert -> monitor is NULL\n");
 	assert(monitor != NULL);
 
+	// citizen id is parsed once into its integer key, which is used by the citizens index and the skip lists, and so is the date, into its day number
+	uint64_t key = citizen_key(citizenID);
+	Date day = (date == NULL) ? NO_DATE : date_parse(date);
+	VirusInfo virus_info = NULL;
+	CountryInfo country_info = NULL;
+	monitor_insert_resolved(monitor, key, day, &virus_info, &country_info, citizenID, firstName, lastName, country, age, virusName, vacc, date);
+}
+
+void monitor_insert_resolved(Monitor monitor, uint64_t key, Date day, VirusInfo * known_virus, CountryInfo * known_country,
+	char * citizenID , char * firstName, char * lastName, char * country, unsigned int age, char * virusName, char * vacc, char * date)
+{
+	if (monitor == NULL)
+		fprintf(stderr, "Error : monitor_insert_resolved -> monitor is NULL\n");
+	assert(monitor != NULL);
+
+	long seq = monitor->bulk_seq++;
+
+	if (key == NO_CITIZEN_KEY)
+	{
+		reject_record(monitor, seq, citizenID, firstName, lastName, country, age, virusName, vacc, date, "INVALID INPUT DATA FORM");
+		return;
+	}
+
+	if (date != NULL && day == NO_DATE)
+	{
+		reject_record(monitor, seq, citizenID, firstName, lastName, country, age, virusName, vacc, date, "INVALID INPUT DATA FORM");
+		return;
+	}
+
 	// search for an already existing citizen record with same ID
-	CitizenInfo citizen_info = (CitizenInfo) hash_search(monitor->citizens_info, citizenID);
-	// search for an already existing virus record with given name
-	VirusInfo virus_info = (VirusInfo) hash_search(monitor->viruses_info, virusName);
-	// search for an already existing country record with given name
-	CountryInfo country_info = (CountryInfo) hash_search(monitor->countries_info, country);
+	CitizenInfo citizen_info = (CitizenInfo) hash_search_citizen(monitor->citizens_info, key);
+	// search for an already existing virus record and country record with given names, unless the caller already knows them
+	if (*known_virus == NULL)
+		*known_virus = (VirusInfo) hash_search(monitor->viruses_info, virusName);
+	if (*known_country == NULL)
+		*known_country = (CountryInfo) hash_search(monitor->countries_info, country);
+	VirusInfo virus_info = *known_virus;
+	CountryInfo country_info = *known_country;
 
 	if (citizen_info != NULL)		// if a citizen record with same ID already exists
 	{
@@ -71,62 +550,332 @@ void monitor_insert(Monitor monitor, char * citizenID , char * firstName, char *
 		if (strcmp(firstName, get_citizen_name(citizen_info)) != 0 || strcmp(lastName, get_citizen_surname(citizen_info)) != 0 
 			|| strcmp(country, get_citizen_country(citizen_info)) != 0 || age != get_citizen_age(citizen_info))
 		{
-			printf("ERROR IN RECORD : %s %s %s %s %d %s %s ", citizenID, firstName, lastName, country, age, virusName, vacc); printf( (date == NULL) ? "\n" : "%s\n", date);
-			printf("INCONSISTENT INPUT DATA\n\n");
+			reject_record(monitor, seq, citizenID, firstName, lastName, country, age, virusName, vacc, date, "INCONSISTENT INPUT DATA");
 			return;
 		}
 
-		if (virus_info != NULL)
+		// during a bulk load duplicates are detected when the skip lists of the virus are built
+		if (virus_info != NULL && !monitor->bulk)
 		{
-			char * temp_date;
+			Date temp_date;
 			// check if new record is duplicate (same ID, but also same virus - that means, an entry with given ID already exists for given virus)
 			// if it exists it is either on the vaccinated skip list or non vaccinated skip list for given virus
-			if (skip_list_search(get_vacc_list(virus_info), citizenID, &temp_date) || skip_list_search(get_non_vacc_list(virus_info), citizenID, &temp_date))
+			if (skip_list_search(get_vacc_list(virus_info), key, &temp_date) || skip_list_search(get_non_vacc_list(virus_info), key, &temp_date))
 			{
-				printf("ERROR IN RECORD : %s %s %s %s %d %s %s ", citizenID, firstName, lastName, country, age, virusName, vacc); printf( (date == NULL) ? "\n" : "%s\n", date);
-				printf("INPUT DATA DUPLICATION\n\n");
+				reject_record(monitor, seq, citizenID, firstName, lastName, country, age, virusName, vacc, date, "INPUT DATA DUPLICATION");
 				return;
 			}
 		}
 	}
 
 	// at last, check for invalid data form, i.e. vaccinated == "YES" but no date is given or vaccinated = "NO" but a date is given
-	if ( ( !strcmp(vacc, "YES") && date == NULL) || (!strcmp(vacc, "NO") && date != NULL) )
+	if (invalid_form(vacc, day))
 	{
-		printf("ERROR IN RECORD : %s %s %s %s %d %s %s ", citizenID, firstName, lastName, country, age, virusName, vacc); printf( (date == NULL) ? "\n" : "%s\n", date);
-		printf("INVALID INPUT DATA FORM\n\n");
-		return;
+		// during a bulk load, a record of an already known citizen and virus may still turn out to be a duplicate
+		// (which is reported first), so the check is repeated when the skip lists of the virus are built
+		if (!monitor->bulk || citizen_info == NULL || virus_info == NULL)
+		{
+			reject_record(monitor, seq, citizenID, firstName, lastName, country, age, virusName, vacc, date, "INVALID INPUT DATA FORM");
+			return;
+		}
 	}
 
 	if (country_info == NULL)
 	{
-		country_info = country_info_create(country);		// if given country name is new, create new country record
+		country_info = country_info_create(country, hash_size(monitor->countries_info));		// if given country name is new, create new country record
 		hash_insert(monitor->countries_info, country_info);			// insert it into countries index for future reference
+		*known_country = country_info;
 	}
 
 	if (citizen_info == NULL)			// given record is a new citizen record (new ID)
 	{
-		citizen_info = citizen_info_create(citizenID, firstName, lastName, age, country_info);	// create new citizen record
+		citizen_info = citizen_info_create(monitor->citizens_arena, citizenID, firstName, lastName, age, country_info);	// create new citizen record
 		hash_insert(monitor->citizens_info, citizen_info);				// insert it into citizens index for future reference
 	}
 
 	if (virus_info == NULL)
 	{
-		virus_info = virus_info_create(virusName, monitor->bloom_size, monitor->max_level, monitor->p);
+		virus_info = new_virus(monitor, virusName);
 		hash_insert(monitor->viruses_info, virus_info);
+		*known_virus = virus_info;
+	}
+
+	if (monitor->bulk)
+	{
+		pending_append(monitor, virus_info, citizen_info, vacc, day, seq);
+		return;
 	}
 
+	// a record appended to a followed file is logged before it is applied (as an insertCitizenRecord), and synced with the rest of its batch
+	if (monitor->wal != NULL)
+		wal_append_insert(monitor->wal, citizenID, firstName, lastName, country, age, virusName, vacc, date);
+
 	// insert citizen into bloom filter, correct skip list, of given virus
 	if (!strcmp(vacc, "YES"))
 	{
-		bloom_insert(get_bloom_filter(virus_info), (unsigned char*) citizenID);	// bloom filter of virus, keeps track of the vaccinated citizens
-		skip_list_insert(get_vacc_list(virus_info), citizen_info, date);		// insert into vaccinated persons skip list if citizen was vaccinated
+		skip_list_insert(get_vacc_list(virus_info), citizen_info, day);		// insert into vaccinated persons skip list if citizen was vaccinated
+		virus_filter_insert(virus_info, citizenID);	// bloom filter of virus, keeps track of the vaccinated citizens
+		sliced_bloom_insert_person(monitor, virus_info, citizenID);
 	}
 	else
-		skip_list_insert(get_non_vacc_list(virus_info), citizen_info, date);	// insert into not vaccinated skip list if citizen was not vaccinated
+		skip_list_insert(get_non_vacc_list(virus_info), citizen_info, day);	// insert into not vaccinated skip list if citizen was not vaccinated
+	virus_count(virus_info, citizen_info, !strcmp(vacc, "YES"), day, 1);			// and count citizen for the country
+	set_citizen_virus(monitor, citizen_info, virus_info, !strcmp(vacc, "YES"), day);	// and keep its status in the citizen record
 	
 }
 
+void monitor_bulk_begin(Monitor monitor)
+{
+	if (monitor == NULL)
+		fprintf(stderr, "Error : monitor_bulk_begin -> monitor is NULL\n");
+	assert(monitor != NULL);
+
+	monitor->bulk = true;
+	monitor->bulk_seq = 0;
+}
+
+/* orders deferred records by citizen id, and records of the same citizen in input order */
+static int pending_record_cmp(const void * a, const void * b)
+{
+	const struct pending_record * record_a = a;
+	const struct pending_record * record_b = b;
+
+	if (record_a->citizen != record_b->citizen)		// there is a single citizen record per id
+	{
+		uint64_t key_a = get_citizen_key(record_a->citizen);
+		uint64_t key_b = get_citizen_key(record_b->citizen);
+		return (key_a > key_b) - (key_a < key_b);
+	}
+	return (record_a->seq > record_b->seq) - (record_a->seq < record_b->seq);
+}
+
+static void reject_pending_record(Monitor monitor, VirusInfo virus_info, struct pending_record * record, char * reason)
+{
+	CitizenInfo citizen_info = record->citizen;
+	char date[DATE_STRING_SIZE];
+	reject_record(monitor, record->seq, get_citizen_id(citizen_info), get_citizen_name(citizen_info), get_citizen_surname(citizen_info), get_citizen_country(citizen_info), 
+		get_citizen_age(citizen_info), get_virus_name(virus_info), record->vacc, (record->date == NO_DATE) ? NULL : date_format(record->date, date), reason);
+}
+
+static void free_pending_record(struct pending_record * record)
+{
+	if (strcmp(record->vacc, "YES") && strcmp(record->vacc, "NO"))
+		free(record->vacc);
+}
+
+/* inserts the deferred records of given virus one by one into its (non empty) skip lists and bloom filter, in input order */
+static void insert_pending_records_sequentially(Monitor monitor, VirusInfo virus_info, struct pending_list * list)
+{
+	SkipList vacc_list = get_vacc_list(virus_info);
+	SkipList non_vacc_list = get_non_vacc_list(virus_info);
+
+	for (long i = 0; i < list->size; i++)
+	{
+		struct pending_record * record = &list->records[i];
+		CitizenInfo citizen_info = record->citizen;
+		char * citizenID = get_citizen_id(citizen_info);
+		Date temp_date;
+
+		if (skip_list_search(vacc_list, get_citizen_key(citizen_info), &temp_date) || skip_list_search(non_vacc_list, get_citizen_key(citizen_info), &temp_date))
+			reject_pending_record(monitor, virus_info, record, "INPUT DATA DUPLICATION");
+		else if (invalid_form(record->vacc, record->date))
+			reject_pending_record(monitor, virus_info, record, "INVALID INPUT DATA FORM");
+		else
+		{
+			if (!strcmp(record->vacc, "YES"))
+			{
+				skip_list_insert(vacc_list, citizen_info, record->date);
+				virus_filter_insert(virus_info, citizenID);
+			}
+			else
+				skip_list_insert(non_vacc_list, citizen_info, record->date);
+			set_citizen_virus(monitor, citizen_info, virus_info, !strcmp(record->vacc, "YES"), record->date);
+		}
+
+		free_pending_record(record);
+	}
+}
+
+/* builds the empty skip lists of given virus from its deferred records : records are sorted by citizen id, so that
+   duplicates end up next to each other, and the levels of both skip lists are then linked in a single pass */
+static void build_pending_records(Monitor monitor, VirusInfo virus_info, struct pending_list * list)
+{
+	qsort(list->records, list->size, sizeof(struct pending_record), pending_record_cmp);
+
+	void ** vacc_data = malloc(list->size * sizeof(void *));
+	Date * vacc_dates = malloc(list->size * sizeof(Date));
+	void ** non_vacc_data = malloc(list->size * sizeof(void *));
+	Date * non_vacc_dates = malloc(list->size * sizeof(Date));
+	if (vacc_data == NULL || vacc_dates == NULL || non_vacc_data == NULL || non_vacc_dates == NULL)
+		fprintf(stderr, "Error : build_pending_records -> malloc\n");
+	assert(vacc_data != NULL && vacc_dates != NULL && non_vacc_data != NULL && non_vacc_dates != NULL);
+
+	long num_of_vacc = 0, num_of_non_vacc = 0;
+	for (long i = 0; i < list->size; )
+	{
+		// records of the same citizen, in input order : the first one of valid form is inserted, the ones following it are duplicates
+		// and the ones preceding it are of invalid form (exactly as if they were inserted one by one)
+		CitizenInfo citizen_info = list->records[i].citizen;
+		bool inserted = false;
+		for ( ; i < list->size && list->records[i].citizen == citizen_info; i++)
+		{
+			struct pending_record * record = &list->records[i];
+			if (inserted)
+				reject_pending_record(monitor, virus_info, record, "INPUT DATA DUPLICATION");
+			else if (invalid_form(record->vacc, record->date))
+				reject_pending_record(monitor, virus_info, record, "INVALID INPUT DATA FORM");
+			else
+			{
+				inserted = true;
+				set_citizen_virus(monitor, citizen_info, virus_info, !strcmp(record->vacc, "YES"), record->date);
+				if (!strcmp(record->vacc, "YES"))
+				{
+					vacc_data[num_of_vacc] = citizen_info;
+					vacc_dates[num_of_vacc++] = record->date;
+				}
+				else
+				{
+					non_vacc_data[num_of_non_vacc] = citizen_info;
+					non_vacc_dates[num_of_non_vacc++] = record->date;
+				}
+			}
+		}
+	}
+
+	skip_list_build(get_vacc_list(virus_info), vacc_data, vacc_dates, num_of_vacc);
+	skip_list_build(get_non_vacc_list(virus_info), non_vacc_data, non_vacc_dates, num_of_non_vacc);
+	for (long i = 0; i < num_of_vacc; i++)
+		virus_filter_insert(virus_info, get_citizen_id(vacc_data[i]));
+
+	for (long i = 0; i < list->size; i++)
+		free_pending_record(&list->records[i]);
+
+	free(vacc_data);
+	free(vacc_dates);
+	free(non_vacc_data);
+	free(non_vacc_dates);
+}
+
+/* inserts the deferred records of given virus into its skip lists and bloom filter */
+static void insert_pending_records(Monitor monitor, VirusInfo virus_info)
+{
+	if (get_virus_id(virus_info) >= monitor->pending_capacity)		// virus has no deferred records
+		return;
+
+	struct pending_list * list = &monitor->pending[get_virus_id(virus_info)];
+
+	// all the vaccinated persons of the virus are known by now, so its bloom filter is sized for them before they are inserted
+	unsigned long num_of_vacc = skip_list_size(get_vacc_list(virus_info));
+	for (long i = 0; i < list->size; i++)
+		num_of_vacc += !strcmp(list->records[i].vacc, "YES");
+	size_bloom_filter(monitor, virus_info, num_of_vacc);
+
+	// skip lists of a virus known before the bulk load (e.g. restored from a snapshot) already have nodes, so records are inserted one by one
+	if (skip_list_is_empty(get_vacc_list(virus_info)) && skip_list_is_empty(get_non_vacc_list(virus_info)))
+		build_pending_records(monitor, virus_info, list);
+	else
+		insert_pending_records_sequentially(monitor, virus_info, list);
+	virus_filter_seal(virus_info);		// an xor filter is built once all the vaccinated persons of the bulk load are in
+
+	free(list->records);
+	list->records = NULL;
+	list->size = list->capacity = 0;
+	virus_recount(virus_info, hash_size(monitor->countries_info));		// counters of the virus are counted in a single pass over each of its skip lists
+}
+
+/* work shared between the threads of monitor_bulk_end : each virus is handled by exactly one thread */
+struct bulk_work {
+	Monitor monitor;
+	VirusInfo * viruses;
+	int num_of_viruses;
+	int next_virus;
+	pthread_mutex_t mutex;
+};
+
+static void * bulk_thread(void * arg)
+{
+	struct bulk_work * work = arg;
+
+	while (true)
+	{
+		pthread_mutex_lock(&work->mutex);
+		int i = work->next_virus++;
+		pthread_mutex_unlock(&work->mutex);
+
+		if (i >= work->num_of_viruses)
+			return NULL;
+		insert_pending_records(work->monitor, work->viruses[i]);
+	}
+}
+
+static int rejection_cmp(const void * a, const void * b)
+{
+	long seq_a = ((const struct rejection *) a)->seq;
+	long seq_b = ((const struct rejection *) b)->seq;
+	return (seq_a > seq_b) - (seq_a < seq_b);
+}
+
+void monitor_bulk_end(Monitor monitor, int num_of_threads)
+{
+	if (monitor == NULL)
+		fprintf(stderr, "Error : monitor_bulk_end -> monitor is NULL\n");
+	assert(monitor != NULL);
+
+	struct bulk_work work;
+	work.monitor = monitor;
+	work.num_of_viruses = 0;
+	work.next_virus = 0;
+	work.viruses = malloc((hash_size(monitor->viruses_info) + 1) * sizeof(VirusInfo));
+	if (work.viruses == NULL)
+		fprintf(stderr, "Error : monitor_bulk_end -> malloc\n");
+	assert(work.viruses != NULL);
+
+	struct hash_cursor cursor;
+	VirusInfo virus_info;
+	hash_cursor_begin(monitor->viruses_info, &cursor);
+	while ((virus_info = hash_cursor_next(&cursor)) != NULL)
+		work.viruses[work.num_of_viruses++] = virus_info;
+	hash_cursor_end(&cursor);
+
+	// skip lists and bloom filters of different viruses are independent, so each virus is built by a single thread
+	if (num_of_threads > work.num_of_viruses)
+		num_of_threads = work.num_of_viruses;
+
+	pthread_mutex_init(&work.mutex, NULL);
+	if (num_of_threads <= 1)
+		bulk_thread(&work);
+	else
+	{
+		pthread_t threads[num_of_threads];
+		for (int i = 0; i < num_of_threads; i++)
+			pthread_create(&threads[i], NULL, bulk_thread, &work);
+		for (int i = 0; i < num_of_threads; i++)
+			pthread_join(threads[i], NULL);
+	}
+	pthread_mutex_destroy(&work.mutex);
+	free(work.viruses);
+
+	// report rejected records in input order, as a record by record load would have
+	qsort(monitor->rejections, monitor->num_of_rejections, sizeof(struct rejection), rejection_cmp);
+	for (long i = 0; i < monitor->num_of_rejections; i++)
+	{
+		fputs(monitor->rejections[i].message, stdout);
+		free(monitor->rejections[i].message);
+	}
+
+	free(monitor->rejections);
+	monitor->rejections = NULL;
+	monitor->num_of_rejections = monitor->rejections_capacity = 0;
+	free(monitor->pending);
+	monitor->pending = NULL;
+	monitor->pending_capacity = 0;
+	monitor->bulk = false;
+
+	// viruses were built in parallel, so the bit-sliced bloom filter (whose rows are shared by all viruses) is built once they are all done
+	if (monitor->sliced_bloom != NULL)
+		rebuild_sliced_bloom(monitor, 0);
+}
+
 void monitor_print(Monitor monitor)
 {
 	if (monitor == NULL)
@@ -147,12 +896,55 @@ void monitor_print(Monitor monitor)
 
 /* main utility functions */
 
-void vaccineStatusBloom(Monitor monitor, char * citizenID, char * virusName)
+/* checks a citizen against the filters of all viruses : with a single probe of the bit-sliced bloom filter if it is kept, otherwise the filter of each virus in turn */
+static void vaccineStatusBloomAll(Monitor monitor, char * citizenID, FILE * out)
+{
+	CitizenInfo citizen_info = (CitizenInfo) hash_search_citizen(monitor->citizens_info, citizen_key(citizenID));
+
+	if (citizen_info == NULL)
+	{
+		fprintf(stderr, "Error : vaccineStatusBloom -> Given citizen ID does not exist in database\n\n");
+		return;
+	}
+
+	fprintf(out, "\nChecking vaccine status of citizen with [ ID = %s ] for all viruses\n", citizenID);
+
+	uint8_t * sets = NULL;
+	if (monitor->sliced_bloom != NULL)
+	{
+		sets = malloc(sliced_bloom_row_size(monitor->sliced_bloom));
+		if (sets == NULL)
+			fprintf(stderr, "Error : vaccineStatusBloom -> malloc\n");
+		assert(sets != NULL);
+		sliced_bloom_check(monitor->sliced_bloom, hash_once((unsigned char *) citizenID), sets);		// MAYBE / NO bitmap of all viruses at once
+	}
+
+	struct hash_cursor cursor;
+	VirusInfo virus_info;
+	hash_cursor_begin(monitor->viruses_info, &cursor);
+	while ((virus_info = hash_cursor_next(&cursor)) != NULL)
+	{
+		int id = get_virus_id(virus_info);
+		bool maybe = (sets != NULL) ? (sets[id / 8] >> (id % 8)) & 1 : virus_filter_check(virus_info, citizenID);
+		fprintf(out, "%s %s\n", get_virus_name(virus_info), maybe ? "MAYBE" : "NOT VACCINATED");
+	}
+	hash_cursor_end(&cursor);
+	fprintf(out, "\n");
+	free(sets);
+}
+
+void vaccineStatusBloom(Monitor monitor, char * citizenID, char * virusName, FILE * out)
 {
 	if (monitor == NULL)
 		fprintf(stderr, "Error : vaccineStatusBloom -> monitor is NULL\n");
 	assert(monitor != NULL);
 
+	if (virusName == NULL)		// no specific virus was given, so check every virus
+	{
+		vaccineStatusBloomAll(monitor, citizenID, out);
+		return;
+	}
+
 	// search for an existing virus record with given virus name
 	VirusInfo virus_info = (VirusInfo) hash_search(monitor->viruses_info, virusName);
 
@@ -163,7 +955,7 @@ void vaccineStatusBloom(Monitor monitor, char * citizenID, char * virusName)
 	}
 
 	// search for an existing cititzen record with given citizen ID
-	CitizenInfo citizen_info = (CitizenInfo) hash_search(monitor->citizens_info, citizenID);
+	CitizenInfo citizen_info = (CitizenInfo) hash_search_citizen(monitor->citizens_info, citizen_key(citizenID));
 
 	if (citizen_info == NULL)
 	{
@@ -171,22 +963,23 @@ void vaccineStatusBloom(Monitor monitor, char * citizenID, char * virusName)
 		return;
 	}
 
-	printf("\nChecking vaccine status of citizen with [ ID = %s ] for [ virus = %s ] \n", citizenID, virusName);
+	fprintf(out, "\nChecking vaccine status of citizen with [ ID = %s ] for [ virus = %s ] \n", citizenID, virusName);
 
-	if (bloom_check(get_bloom_filter(virus_info), (unsigned char *) citizenID))
-		printf("MAYBE\n\n");			// bloom filter check returns true (maybe is in, maybe is not (false positive))
+	if (virus_filter_check(virus_info, citizenID))
+		fprintf(out, "MAYBE\n\n");			// bloom filter check returns true (maybe is in, maybe is not (false positive))
 	else
-		printf("NOT VACCINATED\n\n");	// bloom filter check returns false (definitely is not in)
+		fprintf(out, "NOT VACCINATED\n\n");	// bloom filter check returns false (definitely is not in)
 }
 
-void vaccineStatus(Monitor monitor, char * citizenID, char * virusName)
+void vaccineStatus(Monitor monitor, char * citizenID, char * virusName, FILE * out)
 {
 	if (monitor == NULL)
 		fprintf(stderr, "Error : vaccineStatus -> monitor is NULL\n");
 	assert(monitor != NULL);
 
 	// search for an existing cititzen record with given citizen ID
-	CitizenInfo citizen_info = (CitizenInfo) hash_search(monitor->citizens_info, citizenID);
+	uint64_t key = citizen_key(citizenID);
+	CitizenInfo citizen_info = (CitizenInfo) hash_search_citizen(monitor->citizens_info, key);
 
 	if (citizen_info == NULL)
 	{
@@ -204,46 +997,233 @@ void vaccineStatus(Monitor monitor, char * citizenID, char * virusName)
 			return;
 		}
 
-		printf("\nChecking vaccine status of citizen with [ ID = %s ] for [ virus = %s ] \n", citizenID, virusName);
+		fprintf(out, "\nChecking vaccine status of citizen with [ ID = %s ] for [ virus = %s ] \n", citizenID, virusName);
 
-		char * date = NULL;
+		Date date;
+		char date_str[DATE_STRING_SIZE];
 
-		if (!skip_list_search(get_vacc_list(virus_info), citizenID, &date))		// if citizen id was not found into vaccinated skip list for given virus
-			printf("NOT VACCINATED\n\n");
+		if (!skip_list_search(get_vacc_list(virus_info), key, &date))		// if citizen id was not found into vaccinated skip list for given virus
+			fprintf(out, "NOT VACCINATED\n\n");
 		else
-			printf("VACCINATED ON %s \n\n", date);
+			fprintf(out, "VACCINATED ON %s \n\n", date_format(date, date_str));
 	}
 
 	else
 	{
-		// no specific virus was given, so do the same search, but for every virus
-		printf("\nChecking vaccine status of citizen with [ ID = %s ] for all associated viruses\n", citizenID);
-		VirusInfo virus_info;
-		// iterate upon the hash-table of viruses
-		while ((virus_info = hash_iterate_next(monitor->viruses_info)) != NULL)
+		// no specific virus was given, so print the status of the citizen for every virus it is associated with, as kept in its record (in virus id order)
+		fprintf(out, "\nChecking vaccine status of citizen with [ ID = %s ] for all associated viruses\n", citizenID);
+		int num_of_viruses;
+		const struct citizen_virus * viruses = get_citizen_viruses(citizen_info, &num_of_viruses);
+		for (int i = 0; i < num_of_viruses; i++)
+		{
+			VirusInfo virus_info = hash_entry(monitor->viruses_info, viruses[i].virus_id);
+			char date_str[DATE_STRING_SIZE];
+			if (viruses[i].vaccinated)
+				fprintf(out, "%s YES %s\n", get_virus_name(virus_info), date_format(viruses[i].date, date_str));
+			else
+				fprintf(out, "%s NO\n", get_virus_name(virus_info));
+		}
+		fprintf(out, "\n");
+	}
+
+}
+
+static double elapsed_ns(struct timespec * start, struct timespec * end)
+{
+	return (end->tv_sec - start->tv_sec) * 1e9 + (end->tv_nsec - start->tv_nsec);
+}
+
+/* key of an id of a block, and the position of the id in the block */
+struct batch_key {
+	uint64_t key;
+	int index;
+};
+
+/* a block of ids of a batch, and what is known about each of them so far */
+struct batch_block {
+	char ids[BATCH_BLOCK][BATCH_ID_SIZE];
+	uint64_t keys[BATCH_BLOCK];
+	uint64_t hashes[BATCH_BLOCK];
+	CitizenInfo citizens[BATCH_BLOCK];
+	bool maybe[BATCH_BLOCK];			// the filter of the virus may have the id
+	struct batch_key order[BATCH_BLOCK];	// ids the filter may have, in ascending key order
+	uint64_t sorted_keys[BATCH_BLOCK];
+	bool found[BATCH_BLOCK];			// in the order of sorted_keys
+	Date dates[BATCH_BLOCK];
+};
+
+static int batch_key_cmp(const void * a, const void * b)
+{
+	uint64_t key_a = ((const struct batch_key *) a)->key;
+	uint64_t key_b = ((const struct batch_key *) b)->key;
+	return (key_a > key_b) - (key_a < key_b);
+}
+
+/* reads the next id of a batch (a line, surrounding blanks removed) into given buffer, returns false at the end of the batch (end of file, or an empty line) */
+static bool batch_read_id(FILE * input, char * id)
+{
+	char line[BATCH_ID_SIZE + 2];
+	if (fgets(line, sizeof(line), input) == NULL)
+		return false;
+	if (strchr(line, '\n') == NULL)		// a longer line is cut, and the rest of it skipped
+	{
+		int c;
+		while ((c = fgetc(input)) != EOF && c != '\n')
+			;
+	}
+
+	char * start = line + strspn(line, " \t\r\n");
+	int length = strcspn(start, " \t\r\n");
+	if (length == 0)
+		return false;
+	if (length >= BATCH_ID_SIZE)
+		length = BATCH_ID_SIZE - 1;
+	memcpy(id, start, length);
+	id[length] = '\0';
+	return true;
+}
+
+/* resolves a block of ids in three passes, so that the cache misses of the ids overlap instead of following one another :
+   hashes and prefetches, checks the citizens index and the filter of the virus, then searches the vaccinated skip list for the ids that passed the filter in key order */
+static void batch_resolve(Monitor monitor, VirusInfo virus_info, struct batch_block * block, int size, FILE * output, long * counts)
+{
+	for (int i = 0; i < size; i++)
+	{
+		block->keys[i] = citizen_key(block->ids[i]);
+		block->hashes[i] = hash_once((unsigned char *) block->ids[i]);
+		hash_prefetch_citizen(monitor->citizens_info, block->keys[i]);
+		virus_filter_prefetch(virus_info, block->ids[i], block->hashes[i]);
+	}
+
+	int num_of_maybe = 0;
+	for (int i = 0; i < size; i++)
+	{
+		block->citizens[i] = hash_search_citizen(monitor->citizens_info, block->keys[i]);
+		block->maybe[i] = block->citizens[i] != NULL && virus_filter_check_hash(virus_info, block->ids[i], block->hashes[i]);
+		if (block->maybe[i])
 		{
-			char * date = NULL;
-			if (skip_list_search(get_vacc_list(virus_info), citizenID, &date))		// if citizen id was found into vaccinated skip list for given virus
-				printf("%s YES %s\n", get_virus_name(virus_info), date);
-			else if (skip_list_search(get_non_vacc_list(virus_info), citizenID, &date)) // if citizen id was found into not vaccinated list for given virus
-				printf("%s NO\n", get_virus_name(virus_info));
-			// if citizen is not associated with particular virus, then we dont print anything
+			block->order[num_of_maybe].key = block->keys[i];
+			block->order[num_of_maybe++].index = i;
 		}
-		printf("\n");
 	}
 
+	// keys are sorted along with the positions of their ids, so that batches can run in parallel (a comparator of positions would need the keys of the block in a global)
+	qsort(block->order, num_of_maybe, sizeof(struct batch_key), batch_key_cmp);
+	for (int j = 0; j < num_of_maybe; j++)
+		block->sorted_keys[j] = block->order[j].key;
+	skip_list_search_sorted(get_vacc_list(virus_info), block->sorted_keys, num_of_maybe, block->found, block->dates);
+
+	// results in the order of the ids
+	Date dates[BATCH_BLOCK];
+	for (int i = 0; i < size; i++)
+		dates[i] = NO_DATE;
+	for (int j = 0; j < num_of_maybe; j++)
+		dates[block->order[j].index] = block->found[j] ? block->dates[j] : NO_DATE;
+
+	// strings are put as they are, instead of through a format
+	char date_str[DATE_STRING_SIZE];
+	for (int i = 0; i < size; i++)
+	{
+		fputs(block->ids[i], output);
+		if (block->citizens[i] == NULL)
+		{
+			fputs(" UNKNOWN CITIZEN\n", output);
+			counts[2]++;
+		}
+		else if (dates[i] != NO_DATE)
+		{
+			fputs(" VACCINATED ON ", output);
+			fputs(date_format(dates[i], date_str), output);
+			fputc('\n', output);
+			counts[0]++;
+		}
+		else
+		{
+			fputs(" NOT VACCINATED\n", output);
+			counts[1]++;
+		}
+	}
 }
 
-void populationStatus(Monitor monitor, char * country, char * virusName, char * date1, char * date2)
+void vaccineStatusBatch(Monitor monitor, char * virusName, FILE * input, FILE * out)
+{
+	if (monitor == NULL)
+		fprintf(stderr, "Error : vaccineStatusBatch -> monitor is NULL\n");
+	assert(monitor != NULL);
+
+	VirusInfo virus_info = (VirusInfo) hash_search(monitor->viruses_info, virusName);
+	if (virus_info == NULL)
+	{
+		fprintf(stderr, "Error : vaccineStatusBatch -> Given virus name does not exist in database\n\n");
+		return;
+	}
+
+	struct batch_block * block = malloc(sizeof(struct batch_block));
+	if (block == NULL)
+		fprintf(stderr, "Error : vaccineStatusBatch -> malloc\n");
+	assert(block != NULL);
+
+	// results are gathered in memory, and written out at once when the batch ends
+	char * results;
+	size_t results_size;
+	FILE * output = open_memstream(&results, &results_size);
+	if (output == NULL)
+		fprintf(stderr, "Error : vaccineStatusBatch -> open_memstream\n");
+	assert(output != NULL);
+
+	long counts[3] = { 0, 0, 0 };		// vaccinated, not vaccinated, unknown
+	long num_of_ids = 0;
+	double resolve_ns = 0;
+	bool end = false;
+	while (!end)
+	{
+		int size = 0;
+		while (size < BATCH_BLOCK && !(end = !batch_read_id(input, block->ids[size])))
+			size++;
+
+		struct timespec start, stop;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		batch_resolve(monitor, virus_info, block, size, output, counts);
+		clock_gettime(CLOCK_MONOTONIC, &stop);
+		resolve_ns += elapsed_ns(&start, &stop);
+		num_of_ids += size;
+	}
+	fclose(output);
+	free(block);
+
+	fprintf(out, "\nChecking vaccine status of %ld citizens for [ virus = %s ]\n", num_of_ids, virusName);
+	fwrite(results, 1, results_size, out);
+	free(results);
+	fprintf(out, "%ld vaccinated, %ld not vaccinated, %ld unknown (%.1f ns per id)\n\n", counts[0], counts[1], counts[2], (num_of_ids > 0) ? resolve_ns / num_of_ids : 0.0);
+}
+
+/* persons of every country vaccinated for the virus in [from, to], by age group, counted in a single scan (NULL if from is NO_DATE) */
+static int * all_vaccinated_in_range(Monitor monitor, VirusInfo virus_info, Date from, Date to)
+{
+	if (from == NO_DATE)
+		return NULL;
+
+	int num_of_countries = hash_size(monitor->countries_info);
+	int * counts = malloc(((size_t) num_of_countries * AGE_GROUPS + 1) * sizeof(int));
+	if (counts == NULL)
+		fprintf(stderr, "Error : all_vaccinated_in_range -> malloc\n");
+	assert(counts != NULL);
+
+	virus_counted_in_range_all(virus_info, from, to, counts, num_of_countries);
+	return counts;
+}
+
+void populationStatus(Monitor monitor, char * country, char * virusName, char * date1, char * date2, FILE * out)
 {
 	if (monitor == NULL)
 		fprintf(stderr, "Error : populationStatus -> monitor is NULL\n");
 	assert(monitor != NULL);
 
-	// check for correct dates 
+	// check for correct dates, which are compared as day numbers from now on
+	Date from = NO_DATE, to = NO_DATE;
 	if (date1 != NULL && date2 != NULL)
 	{
-		if (!date_check(date1) || !date_check(date2) || date_cmp(date1, date2) > 0 )
+		if (!date_check(date1) || !date_check(date2) || (from = date_parse(date1)) > (to = date_parse(date2)))
 		{
 			fprintf(stderr, "Error : populationStatus -> Invalid dates\n\n");
 			return;
@@ -276,47 +1256,92 @@ void populationStatus(Monitor monitor, char * country, char * virusName, char *
 			return;
 		}
 
-		int num_of_vaccinated_in_range = skip_list_GroupByCountry(get_vacc_list(virus_info), country, date1, date2);	// get num of vaccinated people of country in given date range
-		int num_of_vaccinated = skip_list_GroupByCountry(get_vacc_list(virus_info), country, NULL, NULL);				// get total num of vaccinated people of country
-		int num_of_not_vaccinated = skip_list_GroupByCountry(get_non_vacc_list(virus_info), country, date1, date2);		// get total num of not vaccinated people of country
+		int num_of_vaccinated = virus_counted(virus_info, get_country_id(country_info), true, -1);			// get total num of vaccinated people of country
+		int num_of_not_vaccinated = virus_counted(virus_info, get_country_id(country_info), false, -1);		// get total num of not vaccinated people of country
+		// vaccinations in a date range are counted by the date index of the country, totals are kept by the virus
+		int num_of_vaccinated_in_range = (from == NO_DATE) ? num_of_vaccinated : virus_counted_in_range(virus_info, get_country_id(country_info), -1, from, to);
 		if (num_of_vaccinated + num_of_not_vaccinated != 0)
 		{	float percentage = 100 * (((float) num_of_vaccinated_in_range)/ (num_of_vaccinated + num_of_not_vaccinated));
-			printf("\n%s %d %f%% \n\n", country, num_of_vaccinated_in_range, percentage);
+			fprintf(out, "\n%s %d %f%% \n\n", country, num_of_vaccinated_in_range, percentage);
 		}
 		else
-			printf("\n%s %d 0%% \n\n", country, num_of_vaccinated_in_range);
+			fprintf(out, "\n%s %d 0%% \n\n", country, num_of_vaccinated_in_range);
 	}	
 	else
 	{
 		// no country argument was given, thus we will do the same but for all countries
+		// vaccinations in a date range of all countries are counted by a single scan of the projection of the virus
+		int * range_counts = all_vaccinated_in_range(monitor, virus_info, from, to);
+		struct hash_cursor cursor;
 		CountryInfo country_info;
 		// iterate upon the hash-table of countries
-		while ((country_info = (CountryInfo) hash_iterate_next(monitor->countries_info)) != NULL)
+		hash_cursor_begin(monitor->countries_info, &cursor);
+		while ((country_info = (CountryInfo) hash_cursor_next(&cursor)) != NULL)
 		{
-			int num_of_vaccinated_in_range = skip_list_GroupByCountry(get_vacc_list(virus_info), get_country_name(country_info), date1, date2);			// get num of vaccinated people of country in given date range
-			int num_of_vaccinated = skip_list_GroupByCountry(get_vacc_list(virus_info), get_country_name(country_info), NULL, NULL);					// get total num of vaccinated people of country
-			int num_of_not_vaccinated = skip_list_GroupByCountry(get_non_vacc_list(virus_info), get_country_name(country_info), date1, date2);			// get total num of not vaccinated people of country
+			int num_of_vaccinated = virus_counted(virus_info, get_country_id(country_info), true, -1);			// get total num of vaccinated people of country
+			int num_of_not_vaccinated = virus_counted(virus_info, get_country_id(country_info), false, -1);		// get total num of not vaccinated people of country
+			int num_of_vaccinated_in_range = num_of_vaccinated;
+			if (range_counts != NULL)
+			{
+				int * in_range = &range_counts[get_country_id(country_info) * AGE_GROUPS];
+				num_of_vaccinated_in_range = in_range[0] + in_range[1] + in_range[2] + in_range[3];
+			}
 			if (num_of_vaccinated + num_of_not_vaccinated != 0)
 			{	float percentage = 100 * (((float) num_of_vaccinated_in_range)/ (num_of_vaccinated + num_of_not_vaccinated));
-				printf("\n%s %d %f%% \n", get_country_name(country_info), num_of_vaccinated_in_range, percentage);
+				fprintf(out, "\n%s %d %f%% \n", get_country_name(country_info), num_of_vaccinated_in_range, percentage);
 			}
 			else
-				printf("\n%s %d 0%% \n", get_country_name(country_info), num_of_vaccinated_in_range);
+				fprintf(out, "\n%s %d 0%% \n", get_country_name(country_info), num_of_vaccinated_in_range);
 		}
-		printf("\n");
+		free(range_counts);
+		hash_cursor_end(&cursor);
+		fprintf(out, "\n");
 	}
 }
 
-void popStatusByAge(Monitor monitor, char * country, char * virusName, char * date1, char * date2)
+/* live counters of the vaccinated (or not vaccinated) persons of a country for the virus, by age group */
+static void count_by_age(VirusInfo virus_info, CountryInfo country_info, bool vaccinated, int * group1, int * group2, int * group3, int * group4)
+{
+	*group1 = virus_counted(virus_info, get_country_id(country_info), vaccinated, 0);
+	*group2 = virus_counted(virus_info, get_country_id(country_info), vaccinated, 1);
+	*group3 = virus_counted(virus_info, get_country_id(country_info), vaccinated, 2);
+	*group4 = virus_counted(virus_info, get_country_id(country_info), vaccinated, 3);
+}
+
+/* persons of a country vaccinated for the virus in [from, to] (all of them if from is NO_DATE), by age group.
+   If range_counts is not NULL, they are taken from the counts of all countries of a single scan, otherwise from the date indexes of the country */
+static void count_by_age_in_range(VirusInfo virus_info, CountryInfo country_info, Date from, Date to, int * range_counts, int * group1, int * group2, int * group3, int * group4)
+{
+	if (from == NO_DATE)
+	{
+		count_by_age(virus_info, country_info, true, group1, group2, group3, group4);
+		return;
+	}
+
+	if (range_counts != NULL)
+	{
+		int * counts = &range_counts[get_country_id(country_info) * AGE_GROUPS];
+		*group1 = counts[0];	*group2 = counts[1];	*group3 = counts[2];	*group4 = counts[3];
+		return;
+	}
+
+	*group1 = virus_counted_in_range(virus_info, get_country_id(country_info), 0, from, to);
+	*group2 = virus_counted_in_range(virus_info, get_country_id(country_info), 1, from, to);
+	*group3 = virus_counted_in_range(virus_info, get_country_id(country_info), 2, from, to);
+	*group4 = virus_counted_in_range(virus_info, get_country_id(country_info), 3, from, to);
+}
+
+void popStatusByAge(Monitor monitor, char * country, char * virusName, char * date1, char * date2, FILE * out)
 {
 	if (monitor == NULL)
 		fprintf(stderr, "Error : popStatusByAge -> monitor is NULL\n");
 	assert(monitor != NULL);
 
-	// check for correct dates 
+	// check for correct dates, which are compared as day numbers from now on
+	Date from = NO_DATE, to = NO_DATE;
 	if (date1 != NULL && date2 != NULL)
 	{
-		if (!date_check(date1) || !date_check(date2) || date_cmp(date1, date2) > 0 )
+		if (!date_check(date1) || !date_check(date2) || (from = date_parse(date1)) > (to = date_parse(date2)))
 		{
 			fprintf(stderr, "Error : popStatusByAge -> Invalid dates\n\n");
 			return;
@@ -352,83 +1377,90 @@ void popStatusByAge(Monitor monitor, char * country, char * virusName, char * da
 		int vacc_20, non_vacc_20, vacc_40, non_vacc_40, vacc_60, non_vacc_60, vacc_older, non_vacc_older;		// total vaccinated/not vaccinated counters
 		int vacc_20_in_range, vacc_40_in_range, vacc_60_in_range, vacc_older_in_range;							// counters refering to the vaccinated in given date range
 		
-		skip_list_GroupByAge(get_vacc_list(virus_info), country, date1, date2, &vacc_20_in_range, &vacc_40_in_range, &vacc_60_in_range, &vacc_older_in_range);
-		skip_list_GroupByAge(get_vacc_list(virus_info), country, NULL, NULL, &vacc_20, &vacc_40, &vacc_60, &vacc_older);
-		skip_list_GroupByAge(get_non_vacc_list(virus_info), country, date1, date2, &non_vacc_20, &non_vacc_40, &non_vacc_60, &non_vacc_older);
+		count_by_age(virus_info, country_info, true, &vacc_20, &vacc_40, &vacc_60, &vacc_older);
+		count_by_age(virus_info, country_info, false, &non_vacc_20, &non_vacc_40, &non_vacc_60, &non_vacc_older);
+		// vaccinations in a date range are counted by the date indexes of the country, totals are kept by the virus
+		count_by_age_in_range(virus_info, country_info, from, to, NULL, &vacc_20_in_range, &vacc_40_in_range, &vacc_60_in_range, &vacc_older_in_range);
 		
-		printf("\n%s\n", country);
+		fprintf(out, "\n%s\n", country);
 		if (vacc_20 + non_vacc_20 != 0)
 		{	float percentage = 100 * (((float) vacc_20_in_range)/ (vacc_20 + non_vacc_20));
-			printf("0-20 %d %f%% \n", vacc_20_in_range, percentage);
+			fprintf(out, "0-20 %d %f%% \n", vacc_20_in_range, percentage);
 		}
 		else
-			printf("0-20 %d 0%% \n", vacc_20_in_range);
+			fprintf(out, "0-20 %d 0%% \n", vacc_20_in_range);
 		
 		if (vacc_40 + non_vacc_40 != 0)
 		{	float percentage = 100 * (((float) vacc_40_in_range)/ (vacc_40 + non_vacc_40));
-			printf("20-40 %d %f%% \n", vacc_40_in_range, percentage);
+			fprintf(out, "20-40 %d %f%% \n", vacc_40_in_range, percentage);
 		}
 		else
-			printf("20-40 %d 0%% \n", vacc_40_in_range);
+			fprintf(out, "20-40 %d 0%% \n", vacc_40_in_range);
 		
 		if (vacc_60 + non_vacc_60 != 0)
 		{	float percentage = 100 * (((float) vacc_60_in_range)/ (vacc_60 + non_vacc_60));
-			printf("40-60 %d %f%% \n", vacc_60_in_range, percentage);
+			fprintf(out, "40-60 %d %f%% \n", vacc_60_in_range, percentage);
 		}
 		else
-			printf("40-60 %d 0%% \n", vacc_60_in_range);
+			fprintf(out, "40-60 %d 0%% \n", vacc_60_in_range);
 		
 		if (vacc_older + non_vacc_older != 0)
 		{	float percentage = 100 * (((float) vacc_older_in_range)/ (vacc_older + non_vacc_older));
-			printf("60+ %d %f%% \n\n", vacc_older_in_range, percentage);
+			fprintf(out, "60+ %d %f%% \n\n", vacc_older_in_range, percentage);
 		}
 		else
-			printf("60+ %d 0%% \n\n", vacc_older_in_range);
+			fprintf(out, "60+ %d 0%% \n\n", vacc_older_in_range);
 	}	
 	else
 	{
 		// no country argument was given, thus we will do the same but for all countries
+		// vaccinations in a date range of all countries are counted by a single scan of the projection of the virus
+		int * range_counts = all_vaccinated_in_range(monitor, virus_info, from, to);
+		struct hash_cursor cursor;
 		CountryInfo country_info;
 		// iterate upon the hash-table of countries
-		while ((country_info = (CountryInfo) hash_iterate_next(monitor->countries_info)) != NULL)
+		hash_cursor_begin(monitor->countries_info, &cursor);
+		while ((country_info = (CountryInfo) hash_cursor_next(&cursor)) != NULL)
 		{
 			int vacc_20, non_vacc_20, vacc_40, non_vacc_40, vacc_60, non_vacc_60, vacc_older, non_vacc_older;		// total vaccinated/not vaccinated counters
 			int vacc_20_in_range, vacc_40_in_range, vacc_60_in_range, vacc_older_in_range;							// counters refering to the vaccinated in given date range
 
-			skip_list_GroupByAge(get_vacc_list(virus_info), get_country_name(country_info), date1, date2, &vacc_20_in_range, &vacc_40_in_range, &vacc_60_in_range, &vacc_older_in_range);
-			skip_list_GroupByAge(get_vacc_list(virus_info), get_country_name(country_info), NULL, NULL, &vacc_20, &vacc_40, &vacc_60, &vacc_older);
-			skip_list_GroupByAge(get_non_vacc_list(virus_info), get_country_name(country_info), date1, date2, &non_vacc_20, &non_vacc_40, &non_vacc_60, &non_vacc_older);
+			count_by_age(virus_info, country_info, true, &vacc_20, &vacc_40, &vacc_60, &vacc_older);
+			count_by_age(virus_info, country_info, false, &non_vacc_20, &non_vacc_40, &non_vacc_60, &non_vacc_older);
+			count_by_age_in_range(virus_info, country_info, from, to, range_counts, &vacc_20_in_range, &vacc_40_in_range, &vacc_60_in_range, &vacc_older_in_range);
 			
-			printf("%s\n", get_country_name(country_info));
+			fprintf(out, "%s\n", get_country_name(country_info));
 			if (vacc_20 + non_vacc_20 != 0)
 			{	float percentage = 100 * (((float) vacc_20_in_range)/ (vacc_20 + non_vacc_20));
-				printf("0-20 %d %f%% \n", vacc_20_in_range, percentage);
+				fprintf(out, "0-20 %d %f%% \n", vacc_20_in_range, percentage);
 			}
 			else
-				printf("0-20 %d 0%% \n", vacc_20_in_range);
+				fprintf(out, "0-20 %d 0%% \n", vacc_20_in_range);
 			
 			if (vacc_40 + non_vacc_40 != 0)
 			{	float percentage = 100 * (((float) vacc_40_in_range)/ (vacc_40 + non_vacc_40));
-				printf("20-40 %d %f%% \n", vacc_40_in_range, percentage);
+				fprintf(out, "20-40 %d %f%% \n", vacc_40_in_range, percentage);
 			}
 			else
-				printf("20-40 %d 0%% \n", vacc_40_in_range);
+				fprintf(out, "20-40 %d 0%% \n", vacc_40_in_range);
 			
 			if (vacc_60 + non_vacc_60 != 0)
 			{	float percentage = 100 * (((float) vacc_60_in_range)/ (vacc_60 + non_vacc_60));
-				printf("40-60 %d %f%% \n", vacc_60_in_range, percentage);
+				fprintf(out, "40-60 %d %f%% \n", vacc_60_in_range, percentage);
 			}
 			else
-				printf("40-60 %d 0%% \n", vacc_60_in_range);
+				fprintf(out, "40-60 %d 0%% \n", vacc_60_in_range);
 			
 			if (vacc_older + non_vacc_older != 0)
 			{	float percentage = 100 * (((float) vacc_older_in_range)/ (vacc_older + non_vacc_older));
-				printf("60+ %d %f%% \n\n", vacc_older_in_range, percentage);
+				fprintf(out, "60+ %d %f%% \n\n", vacc_older_in_range, percentage);
 			}
 			else
-				printf("60+ %d 0%% \n\n", vacc_older_in_range);
+				fprintf(out, "60+ %d 0%% \n\n", vacc_older_in_range);
 		}
-		printf("\n");
+		free(range_counts);
+		hash_cursor_end(&cursor);
+		fprintf(out, "\n");
 	}
 }
 
@@ -447,16 +1479,19 @@ void insertCitizenRecord(Monitor monitor, char * citizenID, char * firstName, ch
 	}
 
 	// check for correct date
+	Date day = NO_DATE;
 	if (date != NULL)
 	{	if (!date_check(date))
 		{
 			fprintf(stderr, "Error : insertCitizenRecord -> Invalid date\n\n");
 			return;
 		}
+		day = date_parse(date);
 	}
 
 	// search for an already existing citizen record with same ID
-	CitizenInfo citizen_info = (CitizenInfo) hash_search(monitor->citizens_info, citizenID);
+	uint64_t key = citizen_key(citizenID);
+	CitizenInfo citizen_info = (CitizenInfo) hash_search_citizen(monitor->citizens_info, key);
 	// search for an already existing virus record with given name
 	VirusInfo virus_info = (VirusInfo) hash_search(monitor->viruses_info, virusName);
 	// search for an already existing country record with given name
@@ -475,16 +1510,17 @@ void insertCitizenRecord(Monitor monitor, char * citizenID, char * firstName, ch
 
 		if (virus_info != NULL)
 		{
-			char * temp_date;
+			Date temp_date;
+			char date_str[DATE_STRING_SIZE];
 			// check if new record is duplicate (same ID, but also same virus - that means, an entry with given ID already exists for given virus)
 			// if it exists it is either on the vaccinated skip list or non vaccinated skip list for given virus
-			if (skip_list_search(get_vacc_list(virus_info), citizenID, &temp_date))
+			if (skip_list_search(get_vacc_list(virus_info), key, &temp_date))
 			{
-				printf("Error : insertCitizenRecord -> CITIZEN %s ALREADY VACCINATED ON %s\n\n", citizenID, temp_date);
+				printf("Error : insertCitizenRecord -> CITIZEN %s ALREADY VACCINATED ON %s\n\n", citizenID, date_format(temp_date, date_str));
 				return;
 			} 
 
-			if (skip_list_search(get_non_vacc_list(virus_info), citizenID, &temp_date))
+			if (skip_list_search(get_non_vacc_list(virus_info), key, &temp_date))
 			{
 				printf("Error : insertCitizenRecord -> CITIZEN %s ALREADY IN THE NOT-VACCINATED LIST\n", citizenID);
 				printf("In case you want to vaccinate the citizen, use /vaccinateNow\n\n");
@@ -495,66 +1531,67 @@ void insertCitizenRecord(Monitor monitor, char * citizenID, char * firstName, ch
 
 	if (country_info == NULL)
 	{
-		country_info = country_info_create(country);		// if given country name is new, create new country record
+		country_info = country_info_create(country, hash_size(monitor->countries_info));		// if given country name is new, create new country record
 		hash_insert(monitor->countries_info, country_info);			// insert it into countries index for future reference
 	}
 
-	// given record is a new citizen record (new ID)
-	// first of all do a small check for valid citizen ID
-	for (int i = 0; i < strlen(citizenID); ++i)
+	// if given record is a new citizen record (new ID), first of all do a small check for valid citizen ID
+	if (citizen_info == NULL && key == NO_CITIZEN_KEY)
 	{
-		if (citizenID[i] < '0' || citizenID[i] > '9')
-		{
-			printf("Error : vaccinateNow -> given citizen ID is not a string of digits\n\n");
-			return;
-		}
+		printf("Error : vaccinateNow -> given citizen ID is not a string of (at most %d) digits\n\n", CITIZEN_KEY_DIGITS);
+		return;
 	}
 
-	citizen_info = citizen_info_create(citizenID, firstName, lastName, age, country_info);		// create new citizen record
-	hash_insert(monitor->citizens_info, citizen_info);				// insert it into citizens index for future reference
+	if (monitor->wal != NULL)
+		wal_log_insert(monitor->wal, citizenID, firstName, lastName, country, age, virusName, vacc, date);	// record is valid, log it before applying it
+
+	if (citizen_info == NULL)
+	{
+		citizen_info = citizen_info_create(monitor->citizens_arena, citizenID, firstName, lastName, age, country_info);		// create new citizen record
+		hash_insert(monitor->citizens_info, citizen_info);				// insert it into citizens index for future reference
+	}
 	
 	if (virus_info == NULL)
 	{
-		virus_info = virus_info_create(virusName, monitor->bloom_size, monitor->max_level, monitor->p);
+		virus_info = new_virus(monitor, virusName);
 		hash_insert(monitor->viruses_info, virus_info);
 	}
 
 	// insert citizen into bloom filter, correct skip list, of given virus
 	if (!strcmp(vacc, "YES"))
 	{
-		bloom_insert(get_bloom_filter(virus_info), (unsigned char*) citizenID);	// bloom filter of virus, keeps track of the vaccinated citizens
-		skip_list_insert(get_vacc_list(virus_info), citizen_info, date);		// insert into vaccinated persons skip list if citizen was vaccinated
+		skip_list_insert(get_vacc_list(virus_info), citizen_info, day);		// insert into vaccinated persons skip list if citizen was vaccinated
+		virus_filter_insert(virus_info, citizenID);	// bloom filter of virus, keeps track of the vaccinated citizens
+		sliced_bloom_insert_person(monitor, virus_info, citizenID);
 	}
 	else
-		skip_list_insert(get_non_vacc_list(virus_info), citizen_info, date);	// insert into not vaccinated skip list if citizen was not vaccinated
+		skip_list_insert(get_non_vacc_list(virus_info), citizen_info, day);	// insert into not vaccinated skip list if citizen was not vaccinated
+	virus_count(virus_info, citizen_info, !strcmp(vacc, "YES"), day, 1);			// and count citizen for the country
+	set_citizen_virus(monitor, citizen_info, virus_info, !strcmp(vacc, "YES"), day);	// and keep its status in the citizen record
 
-	printf("Inserted record for citizen with [ ID = %s ] \n\n", citizenID);
+	if (!monitor->quiet)
+		printf("Inserted record for citizen with [ ID = %s ] \n\n", citizenID);
 }
 
 void vaccinateNow(Monitor monitor, char * citizenID, char * firstName, char * lastName, char * country, int age, char * virusName)
+{
+	vaccinateOnDate(monitor, citizenID, firstName, lastName, country, age, virusName, date_today());		// today's date, as a day number
+}
+
+void vaccinateOnDate(Monitor monitor, char * citizenID, char * firstName, char * lastName, char * country, int age, char * virusName, Date date)
 {
 	if (monitor == NULL)
 		fprintf(stderr, "Error : vaccinateNow -> monitor is NULL\n");
 	assert(monitor != NULL);
 
 	// search for an already existing citizen record with same ID
-	CitizenInfo citizen_info = (CitizenInfo) hash_search(monitor->citizens_info, citizenID);
+	uint64_t key = citizen_key(citizenID);
+	CitizenInfo citizen_info = (CitizenInfo) hash_search_citizen(monitor->citizens_info, key);
 	// search for an already existing virus record with given name
 	VirusInfo virus_info = (VirusInfo) hash_search(monitor->viruses_info, virusName);
 	// search for an already existing country record with given name
 	CountryInfo country_info = (CountryInfo) hash_search(monitor->countries_info, country);
-
-	// create todays date
-	time_t t = time(NULL); 
-	struct tm tm = *localtime(&t);
-  	int year = tm.tm_year + 1900;	int month = tm.tm_mon + 1;	int day = tm.tm_mday;
-  	char day_str[3]; char month_str[3]; char year_str[5];	char todays_date[12] = "";
-  	sprintf(day_str, "%d", day);	sprintf(month_str, "%d", month);	sprintf(year_str, "%d", year);
-  	strcat(todays_date, day_str);
-  	strcat(todays_date, "-");
-  	strcat(todays_date, month_str);
-  	strcat(todays_date, "-");
-  	strcat(todays_date, year_str);
+	char date_str[DATE_STRING_SIZE];		// dates are only formatted for output (and for the log)
 
 	if (virus_info == NULL)
 	{
@@ -572,45 +1609,59 @@ void vaccinateNow(Monitor monitor, char * citizenID, char * firstName, char * la
 			return;
 		}
 
-		char * date;
-		if (skip_list_search(get_vacc_list(virus_info), citizenID, &date))		// citizen with given ID is already vaccinated for given virus
+		Date temp_date;
+		if (skip_list_search(get_vacc_list(virus_info), key, &temp_date))		// citizen with given ID is already vaccinated for given virus
 		{
-			printf("Error : vaccinateNow -> CITIZEN %s ALREADY VACCINATED ON %s\n\n", citizenID, date);
+			printf("Error : vaccinateNow -> CITIZEN %s ALREADY VACCINATED ON %s\n\n", citizenID, date_format(temp_date, date_str));
 			return;
 		}
 
-		if (skip_list_search(get_non_vacc_list(virus_info), citizenID, &date)) // citizen is not vaccinated for given virus, but is on not-vaccinated list
-			skip_list_delete(get_non_vacc_list(virus_info), citizenID);    // remove citizen with given ID from not-vaccinated skip list for virus
+		if (monitor->wal != NULL)
+			wal_log_vaccinate(monitor->wal, citizenID, firstName, lastName, country, age, virusName, date_format(date, date_str));	// vaccination is valid, log it before applying it
 
-		bloom_insert(get_bloom_filter(virus_info), (unsigned char*) citizenID);		// insert into bloom filter of virus
-		skip_list_insert(get_vacc_list(virus_info), citizen_info, todays_date);		// insert into vaccinated persons skip list of virus, with today's date
-		printf("\nVaccinated citizen with [ ID = %s ] for [ virus = %s ] \n\n", citizenID, virusName);
+		if (skip_list_search(get_non_vacc_list(virus_info), key, &temp_date)) // citizen is not vaccinated for given virus, but is on not-vaccinated list
+		{
+			skip_list_delete(get_non_vacc_list(virus_info), key);    // remove citizen with given ID from not-vaccinated skip list for virus
+			virus_count(virus_info, citizen_info, false, NO_DATE, -1);
+		}
+
+		skip_list_insert(get_vacc_list(virus_info), citizen_info, date);		// insert into vaccinated persons skip list of virus, with today's date
+		virus_filter_insert(virus_info, citizenID);		// insert into bloom filter of virus
+		sliced_bloom_insert_person(monitor, virus_info, citizenID);
+		virus_count(virus_info, citizen_info, true, date, 1);
+		set_citizen_virus(monitor, citizen_info, virus_info, true, date);
+		if (!monitor->quiet)
+			printf("\nVaccinated citizen with [ ID = %s ] for [ virus = %s ] \n\n", citizenID, virusName);
 		return;
 	}
 
 	// given ID does not already exist, so create new citizen record
 	// first of all do a small check for valid citizen ID
-	for (int i = 0; i < strlen(citizenID); ++i)
+	if (key == NO_CITIZEN_KEY)
 	{
-		if (citizenID[i] < '0' || citizenID[i] > '9')
-		{
-			printf("Error : vaccinateNow -> given citizen ID is not a string of digits\n\n");
-			return;
-		}
+		printf("Error : vaccinateNow -> given citizen ID is not a string of (at most %d) digits\n\n", CITIZEN_KEY_DIGITS);
+		return;
 	}
 
+	if (monitor->wal != NULL)
+		wal_log_vaccinate(monitor->wal, citizenID, firstName, lastName, country, age, virusName, date_format(date, date_str));	// vaccination is valid, log it before applying it
+
 	if (country_info == NULL)
 	{
-		country_info = country_info_create(country);		// if given country name is new, create new country record
+		country_info = country_info_create(country, hash_size(monitor->countries_info));		// if given country name is new, create new country record
 		hash_insert(monitor->countries_info, country_info);			// insert it into countries index for future reference
 	}
 
-	citizen_info = citizen_info_create(citizenID, firstName, lastName, age, country_info);	// create new citizen record
+	citizen_info = citizen_info_create(monitor->citizens_arena, citizenID, firstName, lastName, age, country_info);	// create new citizen record
 	hash_insert(monitor->citizens_info, citizen_info);				// insert it into citizens index for future reference
 	
-	bloom_insert(get_bloom_filter(virus_info), (unsigned char*) citizenID);		// insert into bloom filter of virus
-	skip_list_insert(get_vacc_list(virus_info), citizen_info, todays_date);		// insert into vaccinated persons skip list of virus, with today's date
-	printf("\nVaccinated citizen with [ ID = %s ] for [ virus = %s ] \n\n", citizenID, virusName);
+	skip_list_insert(get_vacc_list(virus_info), citizen_info, date);		// insert into vaccinated persons skip list of virus, with today's date
+	virus_filter_insert(virus_info, citizenID);		// insert into bloom filter of virus
+	sliced_bloom_insert_person(monitor, virus_info, citizenID);
+	virus_count(virus_info, citizen_info, true, date, 1);
+	set_citizen_virus(monitor, citizen_info, virus_info, true, date);
+	if (!monitor->quiet)
+		printf("\nVaccinated citizen with [ ID = %s ] for [ virus = %s ] \n\n", citizenID, virusName);
 }
 
 void list_nonVaccinated_Persons(Monitor monitor, char * virusName)
@@ -632,6 +1683,322 @@ void list_nonVaccinated_Persons(Monitor monitor, char * virusName)
 	skip_list_print_data(get_non_vacc_list(virus_info));		// just print all citizen records found on not vaccinated skip list
 }
 
+/* resident memory of the process, in bytes (0 if unknown) */
+static size_t resident_memory(void)
+{
+	FILE * file = fopen("/proc/self/statm", "r");
+	if (file == NULL)
+		return 0;
+
+	unsigned long pages_total, pages_resident;
+	int read = fscanf(file, "%lu %lu", &pages_total, &pages_resident);
+	fclose(file);
+
+	return (read == 2) ? pages_resident * (size_t) sysconf(_SC_PAGESIZE) : 0;
+}
+
+void memory_report(Monitor monitor)
+{
+	if (monitor == NULL)
+		fprintf(stderr, "Error : memory_report -> monitor is NULL\n");
+	assert(monitor != NULL);
+
+	int num_of_citizens = hash_size(monitor->citizens_info);
+	size_t arena_bytes = arena_used(monitor->citizens_arena);		// the records themselves, the rest of the slabs is reserved for new ones
+
+	// what the same records would take, with a malloc for each record and each of its strings
+	size_t separate_bytes = 0;
+	struct hash_cursor cursor;
+	CitizenInfo citizen_info;
+	hash_cursor_begin(monitor->citizens_info, &cursor);
+	while ((citizen_info = hash_cursor_next(&cursor)) != NULL)
+		separate_bytes += citizen_info_separate_size(citizen_info);
+	hash_cursor_end(&cursor);
+
+	double per_citizen = (num_of_citizens > 0) ? (double) arena_bytes / num_of_citizens : 0.0;
+	double separate_per_citizen = (num_of_citizens > 0) ? (double) separate_bytes / num_of_citizens : 0.0;
+
+	printf("\nMemory report\n");
+	printf("Citizens : %d\n", num_of_citizens);
+	printf("Citizen records (arena) : %zu bytes used, %.1f bytes per citizen\n", arena_bytes, per_citizen);
+	printf("Citizen records arena slabs : %zu bytes reserved in %d slabs\n", arena_reserved(monitor->citizens_arena), arena_slabs(monitor->citizens_arena));
+	printf("Citizen records (separate mallocs) : %zu bytes, %.1f bytes per citizen\n", separate_bytes, separate_per_citizen);
+	printf("Citizens index : %zu bytes, %.1f bytes per citizen\n", hash_memory(monitor->citizens_info), 
+		(num_of_citizens > 0) ? (double) hash_memory(monitor->citizens_info) / num_of_citizens : 0.0);
+	printf("Process resident memory : %zu bytes\n\n", resident_memory());
+}
+
+#define BENCHMARK_KEY_SIZE 12
+
+void bloom_benchmark(Monitor monitor, int num_of_keys)
+{
+	if (monitor == NULL)
+		fprintf(stderr, "Error : bloom_benchmark -> monitor is NULL\n");
+	assert(monitor != NULL);
+
+	// ids of inserted citizens, followed by as many ids that are not inserted
+	char (* keys)[BENCHMARK_KEY_SIZE] = malloc(2 * (size_t) num_of_keys * BENCHMARK_KEY_SIZE);
+	if (keys == NULL)
+		fprintf(stderr, "Error : bloom_benchmark -> malloc\n");
+	assert(keys != NULL);
+	for (int i = 0; i < 2 * num_of_keys; i++)
+		snprintf(keys[i], BENCHMARK_KEY_SIZE, "%d", i);
+
+	printf("\nBloom filters of %d keys\n", num_of_keys);
+	BloomLayout layouts[] = { BLOOM_CLASSIC, BLOOM_BLOCKED };
+	for (int l = 0; l < 2; l++)
+	{
+		Bloom bloom = new_bloom_filter(monitor, num_of_keys, layouts[l]);
+		struct timespec start, inserted, present, absent;
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (int i = 0; i < num_of_keys; i++)
+			bloom_insert(bloom, (unsigned char *) keys[i]);
+		clock_gettime(CLOCK_MONOTONIC, &inserted);
+
+		int found = 0;
+		for (int i = 0; i < num_of_keys; i++)
+			found += bloom_check(bloom, (unsigned char *) keys[i]);
+		clock_gettime(CLOCK_MONOTONIC, &present);
+
+		int false_positives = 0;
+		for (int i = num_of_keys; i < 2 * num_of_keys; i++)
+			false_positives += bloom_check(bloom, (unsigned char *) keys[i]);
+		clock_gettime(CLOCK_MONOTONIC, &absent);
+
+		if (found != num_of_keys)		// a bloom filter has no false negatives
+			fprintf(stderr, "Error : bloom_benchmark -> %d inserted keys not found\n", num_of_keys - found);
+
+		unsigned int bloom_size;
+		bloom_bits(bloom, &bloom_size);
+		printf("%s (%u bytes, %.1f bits per key, %d hash functions) : FPR %.4f%%, insert %.1f ns, lookup %.1f ns (inserted key), %.1f ns (other key)\n", bloom_layout_name(layouts[l]), bloom_size,
+			8.0 * bloom_size / num_of_keys, bloom_hashes(bloom), 100.0 * false_positives / num_of_keys, elapsed_ns(&start, &inserted) / num_of_keys,
+			elapsed_ns(&inserted, &present) / num_of_keys, elapsed_ns(&present, &absent) / num_of_keys);
+		bloom_destroy(bloom);
+	}
+
+	// filters of fingerprints are sized by their number of keys alone, whatever the settings of the bloom filters, and hash each key once
+	struct timespec start, inserted, present, absent;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	Cuckoo cuckoo = cuckoo_create(num_of_keys);
+	for (int i = 0; i < num_of_keys; i++)
+		cuckoo_insert(cuckoo, hash_once((unsigned char *) keys[i]));
+	clock_gettime(CLOCK_MONOTONIC, &inserted);
+	int found = 0;
+	for (int i = 0; i < num_of_keys; i++)
+		found += cuckoo_check(cuckoo, hash_once((unsigned char *) keys[i]));
+	clock_gettime(CLOCK_MONOTONIC, &present);
+	int false_positives = 0;
+	for (int i = num_of_keys; i < 2 * num_of_keys; i++)
+		false_positives += cuckoo_check(cuckoo, hash_once((unsigned char *) keys[i]));
+	clock_gettime(CLOCK_MONOTONIC, &absent);
+	if (found != num_of_keys)
+		fprintf(stderr, "Error : bloom_benchmark -> %d keys inserted into the cuckoo filter not found\n", num_of_keys - found);
+	printf("cuckoo (%lu bytes, %.1f bits per key) : FPR %.4f%%, insert %.1f ns, lookup %.1f ns (inserted key), %.1f ns (other key)\n", cuckoo_memory(cuckoo),
+		8.0 * cuckoo_memory(cuckoo) / num_of_keys, 100.0 * false_positives / num_of_keys, elapsed_ns(&start, &inserted) / num_of_keys,
+		elapsed_ns(&inserted, &present) / num_of_keys, elapsed_ns(&present, &absent) / num_of_keys);
+
+	// unlike the other filters, a cuckoo filter can delete keys : half of them are deleted, and the other half must still be found
+	int deleted = 0;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int i = 0; i < num_of_keys; i += 2)
+		deleted += cuckoo_delete(cuckoo, hash_once((unsigned char *) keys[i]));
+	clock_gettime(CLOCK_MONOTONIC, &inserted);
+	int kept = 0, still_found = 0;
+	for (int i = 0; i < num_of_keys; i++)
+	{
+		if (i % 2 == 0)
+			still_found += cuckoo_check(cuckoo, hash_once((unsigned char *) keys[i]));
+		else
+			kept += cuckoo_check(cuckoo, hash_once((unsigned char *) keys[i]));
+	}
+	if (deleted != (num_of_keys + 1) / 2)
+		fprintf(stderr, "Error : bloom_benchmark -> %d keys inserted into the cuckoo filter could not be deleted\n", (num_of_keys + 1) / 2 - deleted);
+	if (kept != num_of_keys / 2)
+		fprintf(stderr, "Error : bloom_benchmark -> %d keys of the cuckoo filter not found after deletes\n", num_of_keys / 2 - kept);
+	printf("cuckoo delete : %.1f ns, %d of %d deleted keys still found (false positives)\n", (deleted > 0) ? elapsed_ns(&start, &inserted) / deleted : 0.0,
+		still_found, deleted);
+	cuckoo_destroy(cuckoo);
+
+	// an xor filter is built from all of its keys at once, so the time of an insert is that of the build per key
+	uint64_t * hashes = malloc((size_t) num_of_keys * sizeof(uint64_t) + 1);
+	if (hashes == NULL)
+		fprintf(stderr, "Error : bloom_benchmark -> malloc\n");
+	assert(hashes != NULL);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int i = 0; i < num_of_keys; i++)
+		hashes[i] = hash_once((unsigned char *) keys[i]);
+	XorFilter xor_filter = xor_create(hashes, num_of_keys);
+	clock_gettime(CLOCK_MONOTONIC, &inserted);
+	found = 0;
+	for (int i = 0; i < num_of_keys; i++)
+		found += xor_check(xor_filter, hash_once((unsigned char *) keys[i]));
+	clock_gettime(CLOCK_MONOTONIC, &present);
+	false_positives = 0;
+	for (int i = num_of_keys; i < 2 * num_of_keys; i++)
+		false_positives += xor_check(xor_filter, hash_once((unsigned char *) keys[i]));
+	clock_gettime(CLOCK_MONOTONIC, &absent);
+	if (found != num_of_keys)
+		fprintf(stderr, "Error : bloom_benchmark -> %d keys of the xor filter not found\n", num_of_keys - found);
+	printf("xor (%lu bytes, %.1f bits per key) : FPR %.4f%%, insert %.1f ns, lookup %.1f ns (inserted key), %.1f ns (other key)\n", xor_memory(xor_filter),
+		8.0 * xor_memory(xor_filter) / num_of_keys, 100.0 * false_positives / num_of_keys, elapsed_ns(&start, &inserted) / num_of_keys,
+		elapsed_ns(&inserted, &present) / num_of_keys, elapsed_ns(&present, &absent) / num_of_keys);
+	xor_destroy(xor_filter);
+
+	printf("\n");
+	free(hashes);
+	free(keys);
+}
+
+void bloom_stats(Monitor monitor)
+{
+	if (monitor == NULL)
+		fprintf(stderr, "Error : bloom_stats -> monitor is NULL\n");
+	assert(monitor != NULL);
+
+	if (monitor->filter_kind != FILTER_BLOOM)
+		printf("\nFilters of kind %s\n", filter_kind_name(monitor->filter_kind));
+	else if (monitor->bloom_fpr == 0)
+		printf("\nBloom filters of %u bytes\n", monitor->bloom_size);
+	else
+		printf("\nBloom filters of target false positive rate %g%%%s\n", 100 * monitor->bloom_fpr, monitor->bloom_scalable ? ", scalable" : "");
+
+	unsigned long total_bytes = 0;
+	struct hash_cursor cursor;
+	VirusInfo virus_info;
+	hash_cursor_begin(monitor->viruses_info, &cursor);
+	while ((virus_info = hash_cursor_next(&cursor)) != NULL)
+	{
+		total_bytes += virus_filter_memory(virus_info);
+		if (get_virus_filter_kind(virus_info) != FILTER_BLOOM)
+		{
+			long num_of_vacc = skip_list_size(get_vacc_list(virus_info));
+			printf("%s : %ld vaccinated, %lu bytes (%s, %.1f bits per key)\n", get_virus_name(virus_info), num_of_vacc, virus_filter_memory(virus_info),
+				filter_kind_name(get_virus_filter_kind(virus_info)), (num_of_vacc > 0) ? 8.0 * virus_filter_memory(virus_info) / num_of_vacc : 0.0);
+			continue;
+		}
+		Bloom bloom = get_bloom_filter(virus_info);
+		printf("%s : %ld vaccinated, %lu bytes (%s, %d hash functions", get_virus_name(virus_info), skip_list_size(get_vacc_list(virus_info)),
+			bloom_memory(bloom), bloom_layout_name(bloom_layout(bloom)), bloom_hashes(bloom));
+		if (bloom_capacity(bloom) != 0)
+			printf(", %d sub-filters", bloom_filters(bloom));
+		printf("), fill %.1f%%, estimated FPR %.4f%%\n", 100 * bloom_fill_ratio(bloom), 100 * bloom_estimated_fpr(bloom));
+	}
+	hash_cursor_end(&cursor);
+	if (monitor->sliced_bloom != NULL)
+	{
+		total_bytes += sliced_bloom_memory(monitor->sliced_bloom);
+		printf("All viruses (bit-sliced) : %lu bytes (%d viruses per row, %d hash functions, sized for %lu vaccinated per virus)\n", sliced_bloom_memory(monitor->sliced_bloom),
+			sliced_bloom_sets(monitor->sliced_bloom), sliced_bloom_hashes(monitor->sliced_bloom), monitor->sliced_capacity);
+	}
+	printf("Total : %lu bytes\n\n", total_bytes);
+}
+
+#define READ_BENCHMARK_POPULATION 201		// one query of this many is a populationStatus, the rest are vaccineStatus and vaccineStatusBloom in turn
+
+/* a query of the read benchmark : a vaccineStatus, vaccineStatusBloom or populationStatus of given citizen and virus */
+struct read_query {
+	int kind;
+	char * citizenID;
+	char * virusName;
+};
+
+/* the share of the queries of the read benchmark run by a thread */
+struct read_worker {
+	Monitor monitor;
+	struct read_query * queries;
+	int first;
+	int last;
+};
+
+static void * read_benchmark_thread(void * arg)
+{
+	struct read_worker * worker = arg;
+
+	// results are written into a stream of the thread, as they would be for a query of the query pool, but not printed
+	char * results;
+	size_t results_size;
+	FILE * out = open_memstream(&results, &results_size);
+	if (out == NULL)
+		fprintf(stderr, "Error : read_benchmark -> open_memstream\n");
+	assert(out != NULL);
+
+	for (int i = worker->first; i < worker->last; i++)
+	{
+		struct read_query * query = &worker->queries[i];
+		monitor_read_lock(worker->monitor);
+		if (query->kind == 0)
+			vaccineStatus(worker->monitor, query->citizenID, query->virusName, out);
+		else if (query->kind == 1)
+			vaccineStatusBloom(worker->monitor, query->citizenID, query->virusName, out);
+		else
+			populationStatus(worker->monitor, NULL, query->virusName, NULL, NULL, out);
+		monitor_unlock(worker->monitor);
+		rewind(out);
+	}
+
+	fclose(out);
+	free(results);
+	return NULL;
+}
+
+void read_benchmark(Monitor monitor, int num_of_queries, int max_threads)
+{
+	if (monitor == NULL)
+		fprintf(stderr, "Error : read_benchmark -> monitor is NULL\n");
+	assert(monitor != NULL);
+
+	int num_of_citizens = hash_size(monitor->citizens_info);
+	int num_of_viruses = hash_size(monitor->viruses_info);
+	if (num_of_citizens == 0 || num_of_viruses == 0)
+	{
+		fprintf(stderr, "Error : read_benchmark -> no citizens to query\n\n");
+		return;
+	}
+
+	// queries of random citizens and viruses, the same for every number of threads
+	struct read_query * queries = malloc(num_of_queries * sizeof(struct read_query));
+	if (queries == NULL)
+		fprintf(stderr, "Error : read_benchmark -> malloc\n");
+	assert(queries != NULL);
+	for (int i = 0; i < num_of_queries; i++)
+	{
+		queries[i].kind = (i % READ_BENCHMARK_POPULATION == READ_BENCHMARK_POPULATION - 1) ? 2 : i % 2;
+		queries[i].citizenID = get_citizen_id(hash_entry(monitor->citizens_info, rand() % num_of_citizens));
+		queries[i].virusName = get_virus_name(hash_entry(monitor->viruses_info, rand() % num_of_viruses));
+	}
+
+	printf("\nRead benchmark of %d queries (vaccineStatus, vaccineStatusBloom and one populationStatus in %d), %ld cores\n", num_of_queries, READ_BENCHMARK_POPULATION, sysconf(_SC_NPROCESSORS_ONLN));
+	double single_qps = 0;
+	for (int num_of_threads = 1; ; num_of_threads = (2 * num_of_threads < max_threads) ? 2 * num_of_threads : max_threads)
+	{
+		pthread_t threads[num_of_threads];
+		struct read_worker workers[num_of_threads];
+		struct timespec start, end;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (int t = 0; t < num_of_threads; t++)
+		{
+			workers[t].monitor = monitor;
+			workers[t].queries = queries;
+			workers[t].first = (long) num_of_queries * t / num_of_threads;
+			workers[t].last = (long) num_of_queries * (t + 1) / num_of_threads;
+			pthread_create(&threads[t], NULL, read_benchmark_thread, &workers[t]);
+		}
+		for (int t = 0; t < num_of_threads; t++)
+			pthread_join(threads[t], NULL);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+
+		double qps = num_of_queries / (elapsed_ns(&start, &end) / 1e9);
+		if (num_of_threads == 1)
+			single_qps = qps;
+		printf("%d threads : %.0f queries/sec (%.2fx)\n", num_of_threads, qps, qps / single_qps);
+		if (num_of_threads >= max_threads)
+			break;
+	}
+	printf("\n");
+	free(queries);
+}
+
 void exit_monitor(Monitor monitor)
 {
 	if (monitor == NULL)
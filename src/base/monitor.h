@@ -1,14 +1,66 @@
 /* file: monitor.h */
 #pragma once
+#include <stdio.h>
+#include <stdbool.h>
+#include "hash.h"
+#include "arena.h"
+#include "wal.h"
+#include "date.h"
+#include "bloom.h"
+#include "items.h"
 
 typedef struct monitor * Monitor;
 
 /* creates a monitor object */
 Monitor monitor_create(unsigned int bloom_size, int max_level, float p);
+/* getters of the monitor components */
+HT get_citizens_index(Monitor monitor);
+Arena get_citizens_arena(Monitor monitor);
+HT get_viruses_index(Monitor monitor);
+HT get_countries_index(Monitor monitor);
+unsigned int get_bloom_size(Monitor monitor);
+void set_bloom_size(Monitor monitor, unsigned int bloom_size);
+BloomLayout get_bloom_layout(Monitor monitor);
+void set_bloom_layout(Monitor monitor, BloomLayout bloom_layout);
+/* with a target false positive rate (fpr > 0), the bloom filter of each virus is sized for its number of vaccinated persons instead of being of the bloom size */
+double get_bloom_fpr(Monitor monitor);
+void set_bloom_fpr(Monitor monitor, double fpr);
+/* if scalable, bloom filters of a target false positive rate add larger sub-filters as they fill up, instead of being of a fixed size */
+bool get_bloom_scalable(Monitor monitor);
+void set_bloom_scalable(Monitor monitor, bool scalable);
+/* kind of the membership filter of viruses created from now on (bloom filters are configured by the settings above) */
+FilterKind get_filter_kind(Monitor monitor);
+void set_filter_kind(Monitor monitor, FilterKind filter_kind);
+/* if sliced, a bit-sliced bloom filter of all viruses is kept as well, so that /vaccineStatusBloom of all viruses is a single probe */
+bool get_bloom_sliced(Monitor monitor);
+void set_bloom_sliced(Monitor monitor, bool sliced);
+int get_max_level(Monitor monitor);
+float get_level_prob(Monitor monitor);
+/* logs every following insertCitizenRecord / vaccinateNow into given write-ahead log, before applying it (NULL stops logging) */
+void monitor_set_wal(Monitor monitor, Wal wal);
+/* returns the write-ahead log of the monitor (NULL if not logging) */
+Wal get_wal(Monitor monitor);
+/* if quiet, successful insertCitizenRecord / vaccinateNow are not reported */
+void monitor_set_quiet(Monitor monitor, bool quiet);
 /* destroys a monitor object and all of its components */
 void monitor_destroy(Monitor monitor);
 /* inserts given entry/line from file into all the necessary data structures of the monitor */
 void monitor_insert(Monitor monitor, char * citizenID , char * firstName, char * lastName, char * country, unsigned int age, char * virusName, char * vacc, char * date);
+/* as monitor_insert, for a record whose id key and date (NO_DATE if date is NULL) were already parsed by the caller. *known_virus and *known_country
+   are the virus and country of the record if the caller already knows them (NULL otherwise), and are set as soon as they are known */
+void monitor_insert_resolved(Monitor monitor, uint64_t key, Date day, VirusInfo * known_virus, CountryInfo * known_country,
+	char * citizenID , char * firstName, char * lastName, char * country, unsigned int age, char * virusName, char * vacc, char * date);
+/* reports a line of the input file with a wrong number of fields as INVALID INPUT DATA FORM, in input order among the records of monitor_insert */
+void monitor_reject_fields(Monitor monitor, char ** fields, int num_of_fields);
+/* defers the skip list and bloom filter insertions of monitor_insert until monitor_bulk_end (used by the initial load) */
+void monitor_bulk_begin(Monitor monitor);
+/* inserts all deferred records into the skip lists and bloom filters of their viruses, one thread per virus, and reports rejected records in input order */
+void monitor_bulk_end(Monitor monitor, int num_of_threads);
+/* reader-writer lock of the monitor, for commands run on several threads : queries that only read the monitor hold it shared, and run in parallel,
+   anything that modifies the monitor holds it exclusively. Commands run on a single thread need not take it */
+void monitor_read_lock(Monitor monitor);
+void monitor_write_lock(Monitor monitor);
+void monitor_unlock(Monitor monitor);
 /*prints all the data structures components of the monitor  (mainly for debugging) */ 
 void monitor_print(Monitor monitor);
 
@@ -16,12 +68,27 @@ void monitor_print(Monitor monitor);
 
 /* main utility functions of project*/
 
-void vaccineStatusBloom(Monitor monitor, char * citizenID, char * virusName);
-void vaccineStatus(Monitor monitor, char * citizenID, char * virusName);
-void populationStatus(Monitor monitor, char * country, char * virusName, char * date1, char * date2);
-void popStatusByAge(Monitor monitor, char * country, char * virusName, char * date1, char * date2);
+/* the queries below only read the monitor, and write their results into out (errors go to stderr), so that several of them can run at once under the read lock */
+void vaccineStatusBloom(Monitor monitor, char * citizenID, char * virusName, FILE * out);
+void vaccineStatus(Monitor monitor, char * citizenID, char * virusName, FILE * out);
+/* checks the vaccine status for given virus of the citizens of the ids read from input (one per line, until the end of the file or an empty line), a block of ids at a time,
+   and writes the results of all of them at once */
+void vaccineStatusBatch(Monitor monitor, char * virusName, FILE * input, FILE * out);
+void populationStatus(Monitor monitor, char * country, char * virusName, char * date1, char * date2, FILE * out);
+void popStatusByAge(Monitor monitor, char * country, char * virusName, char * date1, char * date2, FILE * out);
 void insertCitizenRecord(Monitor monitor, char * citizenID, char * firstName, char * lastName, char * country, int age, char * virusName, char * vacc, char * date);
 void vaccinateNow(Monitor monitor, char * citizenID, char * firstName, char * lastName, char * country, int age, char * virusName);
+/* same as vaccinateNow, but with given date as the date of vaccination (used when replaying a log) */
+void vaccinateOnDate(Monitor monitor, char * citizenID, char * firstName, char * lastName, char * country, int age, char * virusName, Date date);
 void list_nonVaccinated_Persons(Monitor monitor, char * virusName);
+/* prints memory taken by the citizen records and their index (arena, versus a malloc per record and string) */
+void memory_report(Monitor monitor);
+/* inserts given number of ids into a bloom filter of each layout (sized as the filters of the monitor), a cuckoo filter and an xor filter, and prints the size, false positive rate and time per insert and lookup of each */
+void bloom_benchmark(Monitor monitor, int num_of_keys);
+/* prints the size, fill ratio and estimated false positive rate of the bloom filter of each virus (the size and bits per key of other filters) */
+void bloom_stats(Monitor monitor);
+/* runs given number of random read queries (vaccineStatus, vaccineStatusBloom and populationStatus, 100 : 100 : 1) on 1, 2, 4, ... up to given number of threads
+   under the read lock, and prints the queries per second of each number of threads */
+void read_benchmark(Monitor monitor, int num_of_queries, int max_threads);
 void exit_monitor(Monitor monitor);
 
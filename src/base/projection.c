@@ -0,0 +1,134 @@
+/* file : projection.c */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "projection.h"
+#include <assert.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_AVX2_KERNEL
+#endif
+
+#define PROJECTION_GROUPS 4		// age groups of the rows
+
+/* a read optimized copy of the persons of a skip list : the columns queries filter on, without the pointers to citizen and country records */
+struct projection {
+	int32_t * country_ids;
+	Date * dates;
+	uint8_t * groups;
+	long size;
+	long capacity;
+};
+
+Projection projection_create(void)
+{
+	Projection projection = malloc(sizeof(struct projection));
+	if (projection == NULL)
+		fprintf(stderr, "Error : projection_create -> malloc\n");
+	assert(projection != NULL);
+
+	projection->country_ids = NULL;
+	projection->dates = NULL;
+	projection->groups = NULL;
+	projection->size = 0;
+	projection->capacity = 0;
+
+	return projection;
+}
+
+void projection_append(Projection projection, int country_id, int group, Date date)
+{
+	if (projection == NULL)
+		fprintf(stderr, "Error : projection_append -> projection is NULL\n");
+	assert(projection != NULL);
+
+	if (projection->size == projection->capacity)
+	{
+		projection->capacity = (projection->capacity == 0) ? 1024 : 2 * projection->capacity;
+		projection->country_ids = realloc(projection->country_ids, projection->capacity * sizeof(int32_t));
+		projection->dates = realloc(projection->dates, projection->capacity * sizeof(Date));
+		projection->groups = realloc(projection->groups, projection->capacity * sizeof(uint8_t));
+		if (projection->country_ids == NULL || projection->dates == NULL || projection->groups == NULL)
+			fprintf(stderr, "Error : projection_append -> realloc\n");
+		assert(projection->country_ids != NULL && projection->dates != NULL && projection->groups != NULL);
+	}
+
+	projection->country_ids[projection->size] = country_id;
+	projection->dates[projection->size] = date;
+	projection->groups[projection->size] = (uint8_t) group;
+	projection->size++;
+}
+
+void projection_clear(Projection projection)
+{
+	projection->size = 0;
+}
+
+/* counts rows [start, end) one by one, into the counters of their country and age group */
+static void count_all_scalar(Projection projection, long start, long end, Date from, Date to, int * counts, int num_of_countries)
+{
+	for (long i = start; i < end; i++)
+	{
+		if (projection->dates[i] >= from && projection->dates[i] <= to && projection->country_ids[i] < num_of_countries)
+			counts[projection->country_ids[i] * PROJECTION_GROUPS + projection->groups[i]]++;
+	}
+}
+
+#ifdef HAVE_AVX2_KERNEL
+/* filters rows by date 8 at a time and counts the matching ones, returns number of rows counted (the rest are left to the scalar kernel) */
+__attribute__((target("avx2")))
+static long count_all_avx2(Projection projection, Date from, Date to, int * counts, int num_of_countries)
+{
+	const __m256i low = _mm256_set1_epi32(from - 1);
+	const __m256i high = _mm256_set1_epi32(to + 1);
+
+	long i = 0;
+	for ( ; i + 8 <= projection->size; i += 8)
+	{
+		__m256i dates = _mm256_loadu_si256((const __m256i *) &projection->dates[i]);
+		__m256i match = _mm256_and_si256(_mm256_cmpgt_epi32(dates, low), _mm256_cmpgt_epi32(high, dates));
+		unsigned int lanes = (unsigned int) _mm256_movemask_ps(_mm256_castsi256_ps(match));
+		while (lanes != 0)		// one bit per matching row, counted into the counters of its country and age group
+		{
+			long row = i + __builtin_ctz(lanes);
+			if (projection->country_ids[row] < num_of_countries)
+				counts[projection->country_ids[row] * PROJECTION_GROUPS + projection->groups[row]]++;
+			lanes &= lanes - 1;
+		}
+	}
+
+	return i;
+}
+#endif
+
+void projection_count_all(Projection projection, Date from, Date to, int * counts, int num_of_countries)
+{
+	if (projection == NULL)
+		fprintf(stderr, "Error : projection_count_all -> projection is NULL\n");
+	assert(projection != NULL);
+
+	memset(counts, 0, (size_t) num_of_countries * PROJECTION_GROUPS * sizeof(int));
+	if (from > to)
+		return;
+
+	long counted = 0;
+#ifdef HAVE_AVX2_KERNEL
+	if (__builtin_cpu_supports("avx2"))
+		counted = count_all_avx2(projection, from, to, counts, num_of_countries);
+#endif
+	count_all_scalar(projection, counted, projection->size, from, to, counts, num_of_countries);
+}
+
+void projection_destroy(Projection projection)
+{
+	if (projection == NULL)
+		fprintf(stderr, "Error : projection_destroy -> projection is NULL\n");
+	assert(projection != NULL);
+
+	free(projection->country_ids);
+	free(projection->dates);
+	free(projection->groups);
+	free(projection);
+}
@@ -0,0 +1,16 @@
+/* file : projection.h */
+#pragma once
+#include "date.h"
+
+typedef struct projection * Projection;
+
+/* creates an empty projection : contiguous columns of country id, age group and date, one row per person */
+Projection projection_create(void);
+/* appends a row for a person of given country id, age group (0 to 3) and date */
+void projection_append(Projection projection, int country_id, int group, Date date);
+/* removes all rows */
+void projection_clear(Projection projection);
+/* counts the rows with date in [from, to] of all countries in one scan, into counts[country_id * 4 + group] (counts has 4 entries per country) */
+void projection_count_all(Projection projection, Date from, Date to, int * counts, int num_of_countries);
+/* deletes the projection */
+void projection_destroy(Projection projection);
@@ -0,0 +1,217 @@
+/* file : query_pool.c */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "monitor.h"
+#include "query_pool.h"
+#include <assert.h>
+
+#define POOL_BACKLOG 1024		// most queries submitted but not written yet, before query_pool_submit waits
+
+/* a submitted query, and its output once it is done */
+struct query {
+	char * command;
+	char * output;
+	size_t output_size;
+	bool done;
+	struct query * next;
+};
+
+struct query_pool {
+	Monitor monitor;
+	QueryFunction run;
+	char * trailer;
+	pthread_t * threads;
+	int num_of_threads;
+	pthread_mutex_t mutex;			// protects the queue and the stop flag
+	pthread_cond_t queued_cond;		// a query was submitted, or the pool is stopping
+	pthread_cond_t taken_cond;		// the last waiting query was taken by a thread
+	pthread_cond_t written_cond;	// outputs of queries were written
+	struct query * first;			// oldest query not written yet
+	struct query * next_to_run;		// oldest query not taken by a thread yet
+	struct query * last;
+	int num_of_queries;				// queries submitted but not written yet
+	bool stop;
+};
+
+/* writes the outputs of the oldest queries that are done, in the order they were submitted (with the mutex held) */
+static void write_done(QueryPool pool)
+{
+	bool written = false;
+	while (pool->first != NULL && pool->first->done)
+	{
+		struct query * query = pool->first;
+		fwrite(query->output, 1, query->output_size, stdout);
+		pool->first = query->next;
+		if (pool->first == NULL)
+			pool->last = NULL;
+		pool->num_of_queries--;
+		free(query->command);
+		free(query->output);
+		free(query);
+		written = true;
+	}
+
+	if (written)
+	{
+		if (pool->first == NULL)		// caught up with the input, whoever typed it is waiting for the output
+			fflush(stdout);
+		pthread_cond_broadcast(&pool->written_cond);
+	}
+}
+
+static void * pool_thread(void * arg)
+{
+	QueryPool pool = arg;
+
+	pthread_mutex_lock(&pool->mutex);
+	while (true)
+	{
+		while (pool->next_to_run == NULL && !pool->stop)
+			pthread_cond_wait(&pool->queued_cond, &pool->mutex);
+		if (pool->next_to_run == NULL)		// stopping, and no query is left
+			break;
+
+		// the read lock is taken before the query (always before the mutex), so that query_pool_pause, once no query is waiting, has only to wait for the running ones
+		pthread_mutex_unlock(&pool->mutex);
+		monitor_read_lock(pool->monitor);
+		pthread_mutex_lock(&pool->mutex);
+		struct query * query = pool->next_to_run;
+		if (query == NULL)		// taken by another thread meanwhile
+		{
+			monitor_unlock(pool->monitor);
+			continue;
+		}
+		pool->next_to_run = query->next;
+		if (pool->next_to_run == NULL)
+			pthread_cond_broadcast(&pool->taken_cond);
+		pthread_mutex_unlock(&pool->mutex);
+
+		FILE * out = open_memstream(&query->output, &query->output_size);
+		if (out == NULL)
+			fprintf(stderr, "Error : pool_thread -> open_memstream\n");
+		assert(out != NULL);
+		pool->run(pool->monitor, query->command, out);
+		fputs(pool->trailer, out);
+		fclose(out);
+
+		// the read lock is released once the output is written (if the queries before it are done), so that every output is written when the write lock is taken
+		pthread_mutex_lock(&pool->mutex);
+		query->done = true;
+		write_done(pool);
+		pthread_mutex_unlock(&pool->mutex);
+		monitor_unlock(pool->monitor);
+		pthread_mutex_lock(&pool->mutex);
+	}
+	pthread_mutex_unlock(&pool->mutex);
+
+	return NULL;
+}
+
+QueryPool query_pool_create(Monitor monitor, int num_of_threads, QueryFunction run, const char * trailer)
+{
+	QueryPool pool = malloc(sizeof(struct query_pool));
+	if (pool == NULL)
+		fprintf(stderr, "Error : query_pool_create -> malloc\n");
+	assert(pool != NULL);
+
+	pool->monitor = monitor;
+	pool->run = run;
+	pool->trailer = strdup(trailer);
+	pool->num_of_threads = num_of_threads;
+	pool->first = NULL;
+	pool->next_to_run = NULL;
+	pool->last = NULL;
+	pool->num_of_queries = 0;
+	pool->stop = false;
+	pthread_mutex_init(&pool->mutex, NULL);
+	pthread_cond_init(&pool->queued_cond, NULL);
+	pthread_cond_init(&pool->taken_cond, NULL);
+	pthread_cond_init(&pool->written_cond, NULL);
+
+	pool->threads = malloc(num_of_threads * sizeof(pthread_t));
+	if (pool->threads == NULL)
+		fprintf(stderr, "Error : query_pool_create -> malloc\n");
+	assert(pool->threads != NULL);
+	for (int i = 0; i < num_of_threads; i++)
+		pthread_create(&pool->threads[i], NULL, pool_thread, pool);
+
+	return pool;
+}
+
+void query_pool_submit(QueryPool pool, const char * command)
+{
+	struct query * query = malloc(sizeof(struct query));
+	if (query == NULL)
+		fprintf(stderr, "Error : query_pool_submit -> malloc\n");
+	assert(query != NULL);
+	query->command = strdup(command);
+	query->output = NULL;
+	query->output_size = 0;
+	query->done = false;
+	query->next = NULL;
+
+	pthread_mutex_lock(&pool->mutex);
+	while (pool->num_of_queries >= POOL_BACKLOG)		// the input is read no faster than the outputs are written
+		pthread_cond_wait(&pool->written_cond, &pool->mutex);
+
+	if (pool->last == NULL)
+		pool->first = query;
+	else
+		pool->last->next = query;
+	pool->last = query;
+	if (pool->next_to_run == NULL)
+		pool->next_to_run = query;
+	pool->num_of_queries++;
+	pthread_cond_signal(&pool->queued_cond);
+	pthread_mutex_unlock(&pool->mutex);
+}
+
+void query_pool_pause(QueryPool pool)
+{
+	pthread_mutex_lock(&pool->mutex);
+	while (pool->next_to_run != NULL)
+		pthread_cond_wait(&pool->taken_cond, &pool->mutex);
+	pthread_mutex_unlock(&pool->mutex);
+
+	monitor_write_lock(pool->monitor);		// waits for the running queries
+}
+
+void query_pool_resume(QueryPool pool)
+{
+	monitor_unlock(pool->monitor);
+}
+
+void query_pool_drain(QueryPool pool)
+{
+	pthread_mutex_lock(&pool->mutex);
+	while (pool->num_of_queries > 0)
+		pthread_cond_wait(&pool->written_cond, &pool->mutex);
+	pthread_mutex_unlock(&pool->mutex);
+}
+
+void query_pool_destroy(QueryPool pool)
+{
+	if (pool == NULL)
+		fprintf(stderr, "Error : query_pool_destroy -> pool is NULL\n");
+	assert(pool != NULL);
+
+	// threads run the queries left before they stop
+	pthread_mutex_lock(&pool->mutex);
+	pool->stop = true;
+	pthread_cond_broadcast(&pool->queued_cond);
+	pthread_mutex_unlock(&pool->mutex);
+	for (int i = 0; i < pool->num_of_threads; i++)
+		pthread_join(pool->threads[i], NULL);
+	fflush(stdout);
+
+	pthread_mutex_destroy(&pool->mutex);
+	pthread_cond_destroy(&pool->queued_cond);
+	pthread_cond_destroy(&pool->taken_cond);
+	pthread_cond_destroy(&pool->written_cond);
+	free(pool->threads);
+	free(pool->trailer);
+	free(pool);
+}
@@ -0,0 +1,24 @@
+/* file : query_pool.h */
+#pragma once
+#include <stdio.h>
+#include "monitor.h"
+
+typedef struct query_pool * QueryPool;
+
+/* function that runs a command that only reads the monitor, writing its output into out */
+typedef void (*QueryFunction)(Monitor monitor, char * command, FILE * out);
+
+/* starts given number of threads that run queries on the monitor in parallel, each one under the read lock of the monitor.
+   The output of every query, followed by given trailer, is written to stdout in the order the queries were submitted */
+QueryPool query_pool_create(Monitor monitor, int num_of_threads, QueryFunction run, const char * trailer);
+/* queues a query (the command is copied), waits first if too many queries are waiting to be written */
+void query_pool_submit(QueryPool pool, const char * command);
+/* waits until every submitted query is running or done, and takes the write lock of the monitor : every query is done and written by then,
+   and none runs until query_pool_resume (used around commands that modify the monitor, or print to stdout on their own) */
+void query_pool_pause(QueryPool pool);
+/* releases the write lock of the monitor taken by query_pool_pause */
+void query_pool_resume(QueryPool pool);
+/* waits until every submitted query is done and written, without taking the write lock, so that the caller can run queries of its own on other threads meanwhile (e.g. a benchmark) */
+void query_pool_drain(QueryPool pool);
+/* waits until every submitted query is done and written, stops the threads and deletes the pool */
+void query_pool_destroy(QueryPool pool);
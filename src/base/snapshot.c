@@ -0,0 +1,446 @@
+/* file : snapshot.c */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "monitor.h"
+#include "snapshot.h"
+#include "hash.h"
+#include "items.h"
+#include "bloom.h"
+#include "skip_list.h"
+#include <assert.h>
+
+/*
+ * Layout of a snapshot (all integers in native byte order, every string is a u32 length followed by its bytes and a '\0')
+ *
+ * (a missing string is stored as the length 0xFFFFFFFF alone), a date is an i32 day number (0 if there is no date)
+ *
+ * header    : magic[8] "VMSNAP", u32 version, u32 bloom size, u32 bloom layout, f64 bloom false positive rate, u32 scalable blooms, u32 filter kind, i32 max level, f32 level probability
+ * countries : u32 count, then for each country in id order : name
+ * citizens  : u64 count, then for each citizen : id, name, surname, i32 age, u32 country id
+ * viruses   : u32 count, then for each virus in id order :
+ *             name, u32 filter kind, then for a bloom filter only, u32 count of bloom filters (sub-filters of a scalable filter), then for each : 
+ *                   u32 layout, u32 hash functions, u64 capacity (0 if not scalable), u64 count of keys, f64 false positive rate, u32 size, bytes
+ *             (cuckoo and xor filters are not written, they are built again from the vaccinated persons)
+ *             u64 count of vaccinated, then for each (ascending id) : citizen id, i32 date
+ *             u64 count of not vaccinated, then for each (ascending id) : citizen id, i32 date
+ */
+
+#define SNAPSHOT_BUFFER_SIZE (1 << 20)
+#define NO_STRING 0xFFFFFFFF
+
+static void write_u32(FILE * file, uint32_t value)
+{
+	fwrite(&value, sizeof(value), 1, file);
+}
+
+static void write_u64(FILE * file, uint64_t value)
+{
+	fwrite(&value, sizeof(value), 1, file);
+}
+
+static void write_f64(FILE * file, double value)
+{
+	fwrite(&value, sizeof(value), 1, file);
+}
+
+static void write_str(FILE * file, const char * str)
+{
+	if (str == NULL)
+	{
+		write_u32(file, NO_STRING);
+		return;
+	}
+
+	uint32_t length = strlen(str);
+	write_u32(file, length);
+	fwrite(str, 1, length + 1, file);
+}
+
+static void write_bloom(FILE * file, Bloom bloom)
+{
+	write_u32(file, bloom_filters(bloom));
+	for ( ; bloom != NULL; bloom = bloom_next(bloom))
+	{
+		write_u32(file, bloom_layout(bloom));
+		write_u32(file, bloom_hashes(bloom));
+		write_u64(file, bloom_capacity(bloom));
+		write_u64(file, bloom_count(bloom));
+		write_f64(file, bloom_fpr(bloom));
+		unsigned int bloom_size;
+		const uint8_t * bits = bloom_bits(bloom, &bloom_size);
+		write_u32(file, bloom_size);
+		fwrite(bits, 1, bloom_size, file);
+	}
+}
+
+static void write_node(void * data, Date date, void * arg)
+{
+	write_str((FILE *) arg, get_citizen_id((CitizenInfo) data));
+	fwrite(&date, sizeof(date), 1, (FILE *) arg);
+}
+
+int monitor_save(Monitor monitor, const char * path)
+{
+	if (monitor == NULL)
+		fprintf(stderr, "Error : monitor_save -> monitor is NULL\n");
+	assert(monitor != NULL);
+
+	FILE * file = fopen(path, "wb");
+	if (file == NULL)
+	{
+		fprintf(stderr, "Error : monitor_save -> could not open file %s\n", path);
+		return -1;
+	}
+	setvbuf(file, NULL, _IOFBF, SNAPSHOT_BUFFER_SIZE);
+
+	char magic[8] = SNAPSHOT_MAGIC;
+	fwrite(magic, 1, sizeof(magic), file);
+	write_u32(file, SNAPSHOT_VERSION);
+	write_u32(file, get_bloom_size(monitor));
+	write_u32(file, get_bloom_layout(monitor));
+	write_f64(file, get_bloom_fpr(monitor));
+	write_u32(file, get_bloom_scalable(monitor));
+	write_u32(file, get_filter_kind(monitor));
+	int32_t max_level = get_max_level(monitor);
+	fwrite(&max_level, sizeof(max_level), 1, file);
+	float p = get_level_prob(monitor);
+	fwrite(&p, sizeof(p), 1, file);
+
+	// countries and viruses are written in id order, so that ids are the same after a restore
+	HT countries = get_countries_index(monitor);
+	int num_of_countries = hash_size(countries);
+	CountryInfo * country_by_id = malloc((num_of_countries + 1) * sizeof(CountryInfo));
+	struct hash_cursor cursor;
+	CountryInfo country_info;
+	hash_cursor_begin(countries, &cursor);
+	while ((country_info = hash_cursor_next(&cursor)) != NULL)
+		country_by_id[get_country_id(country_info)] = country_info;
+	hash_cursor_end(&cursor);
+
+	write_u32(file, num_of_countries);
+	for (int i = 0; i < num_of_countries; i++)
+		write_str(file, get_country_name(country_by_id[i]));
+	free(country_by_id);
+
+	HT citizens = get_citizens_index(monitor);
+	write_u64(file, hash_size(citizens));
+	CitizenInfo citizen_info;
+	hash_cursor_begin(citizens, &cursor);
+	while ((citizen_info = hash_cursor_next(&cursor)) != NULL)
+	{
+		write_str(file, get_citizen_id(citizen_info));
+		write_str(file, get_citizen_name(citizen_info));
+		write_str(file, get_citizen_surname(citizen_info));
+		int32_t age = get_citizen_age(citizen_info);
+		fwrite(&age, sizeof(age), 1, file);
+		write_u32(file, get_country_id(get_citizen_country_info(citizen_info)));
+	}
+	hash_cursor_end(&cursor);
+
+	HT viruses = get_viruses_index(monitor);
+	int num_of_viruses = hash_size(viruses);
+	VirusInfo * virus_by_id = malloc((num_of_viruses + 1) * sizeof(VirusInfo));
+	VirusInfo virus_info;
+	hash_cursor_begin(viruses, &cursor);
+	while ((virus_info = hash_cursor_next(&cursor)) != NULL)
+		virus_by_id[get_virus_id(virus_info)] = virus_info;
+	hash_cursor_end(&cursor);
+
+	write_u32(file, num_of_viruses);
+	for (int i = 0; i < num_of_viruses; i++)
+	{
+		virus_info = virus_by_id[i];
+		write_str(file, get_virus_name(virus_info));
+
+		write_u32(file, get_virus_filter_kind(virus_info));
+		if (get_virus_filter_kind(virus_info) == FILTER_BLOOM)
+			write_bloom(file, get_bloom_filter(virus_info));
+
+		write_u64(file, skip_list_size(get_vacc_list(virus_info)));
+		skip_list_traverse(get_vacc_list(virus_info), write_node, file);
+		write_u64(file, skip_list_size(get_non_vacc_list(virus_info)));
+		skip_list_traverse(get_non_vacc_list(virus_info), write_node, file);
+	}
+	free(virus_by_id);
+
+	// the snapshot is synced to disk, as a write-ahead log is emptied once it is saved
+	bool error = ferror(file) || fflush(file) != 0 || fsync(fileno(file)) == -1;
+	if (fclose(file) != 0 || error)
+	{
+		fprintf(stderr, "Error : monitor_save -> could not write file %s\n", path);
+		return -1;
+	}
+
+	return 0;
+}
+
+/*_____________________________________________________________________________________________________________*/
+
+/* reading position inside the mapped snapshot. Once a read runs past the end, error is set and all following reads fail */
+struct reader {
+	const uint8_t * cur;
+	const uint8_t * end;
+	bool error;
+};
+
+static const void * read_bytes(struct reader * reader, size_t size)
+{
+	if (reader->error || (size_t) (reader->end - reader->cur) < size)
+	{
+		reader->error = true;
+		return NULL;
+	}
+
+	const void * bytes = reader->cur;
+	reader->cur += size;
+	return bytes;
+}
+
+static uint32_t read_u32(struct reader * reader)
+{
+	uint32_t value = 0;
+	const void * bytes = read_bytes(reader, sizeof(value));
+	if (bytes != NULL)
+		memcpy(&value, bytes, sizeof(value));
+	return value;
+}
+
+static uint64_t read_u64(struct reader * reader)
+{
+	uint64_t value = 0;
+	const void * bytes = read_bytes(reader, sizeof(value));
+	if (bytes != NULL)
+		memcpy(&value, bytes, sizeof(value));
+	return value;
+}
+
+static double read_f64(struct reader * reader)
+{
+	double value = 0;
+	const void * bytes = read_bytes(reader, sizeof(value));
+	if (bytes != NULL)
+		memcpy(&value, bytes, sizeof(value));
+	return value;
+}
+
+/* strings are used in place, straight out of the mapping (they are stored with their '\0') */
+static char * read_str(struct reader * reader)
+{
+	uint32_t length = read_u32(reader);
+	if (length == NO_STRING)
+		return NULL;
+	char * str = (char *) read_bytes(reader, (size_t) length + 1);
+	if (str != NULL && str[length] != '\0')
+	{
+		reader->error = true;
+		return NULL;
+	}
+	return str;
+}
+
+/* restores a bloom filter (and its sub-filters), returns NULL if the snapshot is corrupted */
+static Bloom read_bloom(struct reader * reader)
+{
+	Bloom bloom = NULL;
+	uint32_t num_of_filters = read_u32(reader);
+	for (uint32_t i = 0; i < num_of_filters; i++)
+	{
+		uint32_t layout = read_u32(reader);
+		uint32_t num_of_hashes = read_u32(reader);
+		uint64_t capacity = read_u64(reader);
+		uint64_t count = read_u64(reader);
+		double fpr = read_f64(reader);
+		uint32_t bloom_size = read_u32(reader);
+		const uint8_t * bits = read_bytes(reader, bloom_size);
+		if (reader->error || bloom_size == 0 || layout > BLOOM_BLOCKED || num_of_hashes == 0 || num_of_hashes > BLOOM_MAX_HASHES || (i > 0 && capacity == 0))
+		{
+			if (bloom != NULL)
+				bloom_destroy(bloom);
+			return NULL;
+		}
+
+		Bloom sub_filter = bloom_create(bloom_size, num_of_hashes, layout);
+		bloom_load(sub_filter, bits, bloom_size);
+		if (capacity != 0)
+			bloom_set_scalable(sub_filter, capacity, count, fpr);
+
+		if (bloom == NULL)
+			bloom = sub_filter;
+		else
+			bloom_chain(bloom, sub_filter);
+	}
+	return bloom;
+}
+
+/* restores the levels of a skip list of the virus from the (already sorted) entries of the snapshot */
+static bool restore_skip_list(struct reader * reader, HT citizens, VirusInfo virus_info, bool vaccinated)
+{
+	SkipList skip_list = vaccinated ? get_vacc_list(virus_info) : get_non_vacc_list(virus_info);
+	uint64_t count = read_u64(reader);
+	if (reader->error || count > (uint64_t) (reader->end - reader->cur))
+		return false;
+
+	void ** data = malloc((count + 1) * sizeof(void *));
+	Date * dates = malloc((count + 1) * sizeof(Date));
+	if (data == NULL || dates == NULL)
+		fprintf(stderr, "Error : restore_skip_list -> malloc\n");
+	assert(data != NULL && dates != NULL);
+
+	for (uint64_t i = 0; i < count && !reader->error; i++)
+	{
+		char * citizenID = read_str(reader);
+		dates[i] = (Date) read_u32(reader);
+		data[i] = (citizenID == NULL) ? NULL : hash_search(citizens, citizenID);
+		if (data[i] == NULL)
+			reader->error = true;
+	}
+
+	if (!reader->error)
+	{
+		skip_list_build(skip_list, data, dates, count);
+		for (uint64_t i = 0; i < count; i++)
+			citizen_set_virus(data[i], get_virus_id(virus_info), vaccinated, dates[i]);
+	}
+
+	free(data);
+	free(dates);
+	return !reader->error;
+}
+
+Monitor monitor_restore(const char * path)
+{
+	int fd = open(path, O_RDONLY);
+	if (fd == -1)
+	{
+		fprintf(stderr, "Error : monitor_restore -> could not open file %s\n", path);
+		return NULL;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) == -1 || st.st_size == 0)
+	{
+		fprintf(stderr, "Error : monitor_restore -> invalid snapshot %s\n", path);
+		close(fd);
+		return NULL;
+	}
+
+	size_t size = st.st_size;
+	const uint8_t * map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+	{
+		fprintf(stderr, "Error : monitor_restore -> mmap\n");
+		return NULL;
+	}
+	madvise((void *) map, size, MADV_SEQUENTIAL);
+
+	struct reader reader = { map, map + size, false };
+
+	const char * magic = read_bytes(&reader, 8);
+	uint32_t version = read_u32(&reader);
+	if (magic == NULL || strncmp(magic, SNAPSHOT_MAGIC, 8) != 0 || version != SNAPSHOT_VERSION)
+	{
+		fprintf(stderr, "Error : monitor_restore -> %s is not a snapshot of version %d\n", path, SNAPSHOT_VERSION);
+		munmap((void *) map, size);
+		return NULL;
+	}
+
+	uint32_t bloom_size = read_u32(&reader);
+	uint32_t layout = read_u32(&reader);
+	double fpr = read_f64(&reader);
+	uint32_t scalable = read_u32(&reader);
+	uint32_t filter_kind = read_u32(&reader);
+	int32_t max_level = (int32_t) read_u32(&reader);
+	float p;
+	const void * p_bytes = read_bytes(&reader, sizeof(p));
+	if (reader.error || layout > BLOOM_BLOCKED || filter_kind > FILTER_XOR)
+	{
+		fprintf(stderr, "Error : monitor_restore -> snapshot %s is truncated or corrupted\n", path);
+		munmap((void *) map, size);
+		return NULL;
+	}
+	memcpy(&p, p_bytes, sizeof(p));
+
+	Monitor monitor = monitor_create(bloom_size, max_level, p);
+	set_bloom_layout(monitor, layout);
+	set_bloom_fpr(monitor, fpr);
+	set_bloom_scalable(monitor, scalable);
+	set_filter_kind(monitor, filter_kind);
+	HT countries = get_countries_index(monitor);
+	HT citizens = get_citizens_index(monitor);
+	HT viruses = get_viruses_index(monitor);
+
+	uint32_t num_of_countries = read_u32(&reader);
+	CountryInfo * country_by_id = malloc((num_of_countries + 1) * sizeof(CountryInfo));
+	if (country_by_id == NULL)
+		fprintf(stderr, "Error : monitor_restore -> malloc\n");
+	assert(country_by_id != NULL);
+
+	for (uint32_t i = 0; i < num_of_countries && !reader.error; i++)
+	{
+		char * country_name = read_str(&reader);
+		if (country_name == NULL)
+			break;
+		country_by_id[i] = country_info_create(country_name, i);
+		hash_insert(countries, country_by_id[i]);
+	}
+
+	uint64_t num_of_citizens = read_u64(&reader);
+	for (uint64_t i = 0; i < num_of_citizens && !reader.error; i++)
+	{
+		char * citizenID = read_str(&reader);
+		char * firstName = read_str(&reader);
+		char * lastName = read_str(&reader);
+		int32_t age = (int32_t) read_u32(&reader);
+		uint32_t country_id = read_u32(&reader);
+		if (reader.error || country_id >= num_of_countries)
+		{
+			reader.error = true;
+			break;
+		}
+		hash_insert(citizens, citizen_info_create(get_citizens_arena(monitor), citizenID, firstName, lastName, age, country_by_id[country_id]));
+	}
+	free(country_by_id);
+
+	uint32_t num_of_viruses = read_u32(&reader);
+	for (uint32_t i = 0; i < num_of_viruses && !reader.error; i++)
+	{
+		char * virusName = read_str(&reader);
+		uint32_t virus_filter_kind = read_u32(&reader);
+		Bloom bloom = (virus_filter_kind == FILTER_BLOOM) ? read_bloom(&reader) : NULL;
+		if (reader.error || virus_filter_kind > FILTER_XOR || (virus_filter_kind == FILTER_BLOOM && bloom == NULL))
+		{
+			reader.error = true;
+			break;
+		}
+
+		VirusInfo virus_info = virus_info_create(virusName, i, virus_filter_kind, bloom, max_level, p);
+		hash_insert(viruses, virus_info);
+
+		if (!restore_skip_list(&reader, citizens, virus_info, true) || !restore_skip_list(&reader, citizens, virus_info, false))
+			reader.error = true;
+		else
+		{
+			virus_filter_seal(virus_info);		// a cuckoo or xor filter is built from the restored vaccinated persons
+			virus_recount(virus_info, hash_size(countries));
+		}
+	}
+
+	munmap((void *) map, size);
+
+	if (reader.error)
+	{
+		fprintf(stderr, "Error : monitor_restore -> snapshot %s is truncated or corrupted\n", path);
+		monitor_destroy(monitor);
+		return NULL;
+	}
+
+	return monitor;
+}
@@ -0,0 +1,11 @@
+/* file : snapshot.h */
+#pragma once
+#include "monitor.h"
+
+#define SNAPSHOT_MAGIC "VMSNAP"
+#define SNAPSHOT_VERSION 6
+
+/* writes a binary image of the whole monitor (citizens, countries, bloom filters and skip lists of viruses) into given file and syncs it to disk, returns 0 on success, -1 on error */
+int monitor_save(Monitor monitor, const char * path);
+/* creates a new monitor from a binary image written by monitor_save, returns NULL on error */
+Monitor monitor_restore(const char * path);
@@ -0,0 +1,444 @@
+/* file : tail.c */
+#define _GNU_SOURCE			// pipe2
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+#include "monitor.h"
+#include "loader.h"
+#include "tail.h"
+#include <assert.h>
+
+#define EVENTS_BUFFER_SIZE 4096
+
+/* a followed file, and how much of it has been read */
+struct followed_file {
+	char * path;
+	off_t offset;				// records before offset are already read
+	char * partial;				// last line read, if its newline has not been written yet
+	size_t partial_size;
+};
+
+/* complete record lines read from a followed file, waiting to be applied to the monitor */
+struct batch {
+	char * text;				// lines, each one ending with a newline
+	size_t size;
+	long num_of_records;
+	struct timespec read_time;	// when the lines were read
+	struct batch * next;
+};
+
+struct tail {
+	char * path;
+	bool directory;				// true if every file of the directory is followed
+	int inotify_fd;
+	int stop_pipe[2];			// written to stop the background thread
+	int ready_pipe[2];			// written by the background thread for every new batch
+	struct followed_file * files;
+	int num_of_files;
+	int files_capacity;
+	pthread_t thread;
+	pthread_mutex_t mutex;		// protects the batch queue and the stats
+	struct batch * first;
+	struct batch * last;
+	long num_of_pending;		// records read, but not applied yet
+	long num_of_applied;
+	double last_lag;			// seconds the last applied batch waited, from being read until being applied
+	double max_lag;
+};
+
+static double elapsed(struct timespec * from, struct timespec * to)
+{
+	return (to->tv_sec - from->tv_sec) + (to->tv_nsec - from->tv_nsec) / 1e9;
+}
+
+/* starts following given file from given offset, returns its entry */
+static struct followed_file * follow_file(Tail tail, const char * path, off_t offset)
+{
+	if (tail->num_of_files == tail->files_capacity)
+	{
+		tail->files_capacity = (tail->files_capacity == 0) ? 8 : 2 * tail->files_capacity;
+		tail->files = realloc(tail->files, tail->files_capacity * sizeof(struct followed_file));
+		if (tail->files == NULL)
+			fprintf(stderr, "Error : follow_file -> realloc\n");
+		assert(tail->files != NULL);
+	}
+
+	struct followed_file * file = &tail->files[tail->num_of_files++];
+	file->path = strdup(path);
+	file->offset = offset;
+	file->partial = NULL;
+	file->partial_size = 0;
+	return file;
+}
+
+static struct followed_file * find_file(Tail tail, const char * path)
+{
+	for (int i = 0; i < tail->num_of_files; i++)
+		if (!strcmp(tail->files[i].path, path))
+			return &tail->files[i];
+	return NULL;
+}
+
+/* queues a batch of complete lines, and wakes up the thread applying them */
+static void push_batch(Tail tail, char * text, size_t size)
+{
+	struct batch * batch = malloc(sizeof(struct batch));
+	if (batch == NULL)
+		fprintf(stderr, "Error : push_batch -> malloc\n");
+	assert(batch != NULL);
+
+	batch->text = text;
+	batch->size = size;
+	batch->num_of_records = 0;
+	for (size_t i = 0; i < size; i++)
+		if (text[i] == '\n')
+			batch->num_of_records++;
+	clock_gettime(CLOCK_MONOTONIC, &batch->read_time);
+	batch->next = NULL;
+
+	pthread_mutex_lock(&tail->mutex);
+	if (tail->last == NULL)
+		tail->first = batch;
+	else
+		tail->last->next = batch;
+	tail->last = batch;
+	tail->num_of_pending += batch->num_of_records;
+	pthread_mutex_unlock(&tail->mutex);
+
+	// pipe is non blocking : if it is full, the applying thread has not woken up yet, and will find this batch too
+	if (write(tail->ready_pipe[1], "", 1) == -1 && errno != EAGAIN)
+		fprintf(stderr, "Error : push_batch -> write\n");
+}
+
+/* reads whatever was appended to given file since last time, and queues its complete lines as a batch */
+static void read_appended(Tail tail, struct followed_file * file)
+{
+	int fd = open(file->path, O_RDONLY);
+	if (fd == -1)
+		return;
+
+	struct stat st;
+	if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode))
+	{
+		close(fd);
+		return;
+	}
+
+	if (st.st_size < file->offset)		// file was truncated (or rewritten), so it is followed from its start again
+	{
+		file->offset = 0;
+		free(file->partial);
+		file->partial = NULL;
+		file->partial_size = 0;
+	}
+
+	size_t appended = st.st_size - file->offset;
+	if (appended == 0)
+	{
+		close(fd);
+		return;
+	}
+
+	char * buffer = malloc(file->partial_size + appended);
+	if (buffer == NULL)
+		fprintf(stderr, "Error : read_appended -> malloc\n");
+	assert(buffer != NULL);
+
+	if (file->partial_size > 0)
+		memcpy(buffer, file->partial, file->partial_size);
+
+	size_t size = file->partial_size;
+	while (size < file->partial_size + appended)
+	{
+		ssize_t bytes = pread(fd, buffer + size, file->partial_size + appended - size, file->offset + size - file->partial_size);
+		if (bytes <= 0)
+			break;
+		size += bytes;
+	}
+	close(fd);
+	file->offset += size - file->partial_size;
+
+	// lines are applied only once their newline is written, the rest is kept for next time
+	size_t complete = size;
+	while (complete > 0 && buffer[complete-1] != '\n')
+		complete--;
+
+	free(file->partial);
+	file->partial_size = size - complete;
+	file->partial = NULL;
+	if (file->partial_size > 0)
+	{
+		file->partial = malloc(file->partial_size);
+		if (file->partial == NULL)
+			fprintf(stderr, "Error : read_appended -> malloc\n");
+		assert(file->partial != NULL);
+		memcpy(file->partial, buffer + complete, file->partial_size);
+	}
+
+	if (complete > 0)
+		push_batch(tail, buffer, complete);
+	else
+		free(buffer);
+}
+
+static void handle_event(Tail tail, struct inotify_event * event)
+{
+	if (event->mask & IN_Q_OVERFLOW)		// events were lost, so check all files
+	{
+		for (int i = 0; i < tail->num_of_files; i++)
+			read_appended(tail, &tail->files[i]);
+		return;
+	}
+
+	if (!tail->directory)
+	{
+		read_appended(tail, &tail->files[0]);
+		return;
+	}
+
+	if (event->len == 0 || (event->mask & IN_ISDIR))
+		return;
+
+	char path[strlen(tail->path) + strlen(event->name) + 2];
+	sprintf(path, "%s/%s", tail->path, event->name);
+
+	struct followed_file * file = find_file(tail, path);
+	if (file == NULL)
+		file = follow_file(tail, path, 0);		// files created after following started are read from their start
+	else if (event->mask & (IN_CREATE | IN_MOVED_TO))
+	{
+		file->offset = 0;
+		free(file->partial);
+		file->partial = NULL;
+		file->partial_size = 0;
+	}
+
+	read_appended(tail, file);
+}
+
+static void * tail_thread(void * arg)
+{
+	Tail tail = arg;
+	char events[EVENTS_BUFFER_SIZE] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+
+	struct pollfd fds[2];
+	fds[0].fd = tail->inotify_fd;
+	fds[0].events = POLLIN;
+	fds[1].fd = tail->stop_pipe[0];
+	fds[1].events = POLLIN;
+
+	while (true)
+	{
+		if (poll(fds, 2, -1) == -1)
+		{
+			if (errno == EINTR)
+				continue;
+			fprintf(stderr, "Error : tail_thread -> poll\n");
+			break;
+		}
+
+		if (fds[1].revents)
+			break;
+
+		ssize_t length = read(tail->inotify_fd, events, sizeof(events));
+		if (length <= 0)
+			continue;
+
+		for (char * ptr = events; ptr < events + length; )
+		{
+			struct inotify_event * event = (struct inotify_event *) ptr;
+			handle_event(tail, event);
+			ptr += sizeof(struct inotify_event) + event->len;
+		}
+	}
+
+	return NULL;
+}
+
+Tail tail_start(const char * path)
+{
+	struct stat st;
+	if (stat(path, &st) == -1)
+	{
+		fprintf(stderr, "Error : tail_start -> could not find %s\n", path);
+		return NULL;
+	}
+
+	Tail tail = malloc(sizeof(struct tail));
+	if (tail == NULL)
+		fprintf(stderr, "Error : tail_start -> malloc\n");
+	assert(tail != NULL);
+
+	tail->path = strdup(path);
+	tail->directory = S_ISDIR(st.st_mode);
+	tail->files = NULL;
+	tail->num_of_files = tail->files_capacity = 0;
+	tail->first = tail->last = NULL;
+	tail->num_of_pending = tail->num_of_applied = 0;
+	tail->last_lag = tail->max_lag = 0.0;
+
+	tail->inotify_fd = inotify_init1(IN_CLOEXEC);
+	if (tail->inotify_fd == -1)
+		fprintf(stderr, "Error : tail_start -> inotify_init1\n");
+	assert(tail->inotify_fd != -1);
+
+	uint32_t mask = tail->directory ? (IN_CREATE | IN_MODIFY | IN_MOVED_TO | IN_CLOSE_WRITE) : (IN_MODIFY | IN_CLOSE_WRITE);
+	if (inotify_add_watch(tail->inotify_fd, path, mask) == -1)
+	{
+		fprintf(stderr, "Error : tail_start -> could not watch %s\n", path);
+		close(tail->inotify_fd);
+		free(tail->path);
+		free(tail);
+		return NULL;
+	}
+
+	// records already in the followed files are not applied, only the ones appended from now on
+	if (!tail->directory)
+		follow_file(tail, path, st.st_size);
+	else
+	{
+		DIR * dir = opendir(path);
+		struct dirent * entry;
+		while (dir != NULL && (entry = readdir(dir)) != NULL)
+		{
+			char file_path[strlen(path) + strlen(entry->d_name) + 2];
+			sprintf(file_path, "%s/%s", path, entry->d_name);
+			struct stat file_st;
+			if (stat(file_path, &file_st) == 0 && S_ISREG(file_st.st_mode))
+				follow_file(tail, file_path, file_st.st_size);
+		}
+		if (dir != NULL)
+			closedir(dir);
+	}
+
+	if (pipe(tail->stop_pipe) == -1 || pipe2(tail->ready_pipe, O_NONBLOCK | O_CLOEXEC) == -1)
+		fprintf(stderr, "Error : tail_start -> pipe\n");
+	pthread_mutex_init(&tail->mutex, NULL);
+	pthread_create(&tail->thread, NULL, tail_thread, tail);
+
+	return tail;
+}
+
+int tail_fd(Tail tail)
+{
+	return tail->ready_pipe[0];
+}
+
+long tail_apply(Tail tail, Monitor monitor)
+{
+	if (tail == NULL)
+		fprintf(stderr, "Error : tail_apply -> tail is NULL\n");
+	assert(tail != NULL);
+
+	char drain[64];
+	while (read(tail->ready_pipe[0], drain, sizeof(drain)) > 0)
+		;
+
+	pthread_mutex_lock(&tail->mutex);
+	struct batch * batch = tail->first;
+	tail->first = tail->last = NULL;
+	pthread_mutex_unlock(&tail->mutex);
+
+	long num_of_records = 0;
+	char * fields[RECORD_FIELDS];
+	while (batch != NULL)
+	{
+		// the whole batch is applied before the next query is served, so no query sees a half applied record
+		char * line = batch->text;
+		char * end = batch->text + batch->size;
+		while (line < end)
+		{
+			char * newline = memchr(line, '\n', end - line);
+			*newline = '\0';
+			loader_insert_fields(monitor, fields, loader_split_line(line, fields, RECORD_FIELDS));
+			line = newline + 1;
+		}
+
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		pthread_mutex_lock(&tail->mutex);
+		tail->num_of_pending -= batch->num_of_records;
+		tail->num_of_applied += batch->num_of_records;
+		tail->last_lag = elapsed(&batch->read_time, &now);
+		if (tail->last_lag > tail->max_lag)
+			tail->max_lag = tail->last_lag;
+		pthread_mutex_unlock(&tail->mutex);
+
+		num_of_records += batch->num_of_records;
+		struct batch * next = batch->next;
+		free(batch->text);
+		free(batch);
+		batch = next;
+	}
+
+	// applied records were logged without waiting for their sync, a single sync puts them all on disk before any query sees them
+	if (get_wal(monitor) != NULL && num_of_records > 0)
+		wal_sync(get_wal(monitor));
+
+	return num_of_records;
+}
+
+void tail_print_stats(Tail tail)
+{
+	if (tail == NULL)
+		fprintf(stderr, "Error : tail_print_stats -> tail is NULL\n");
+	assert(tail != NULL);
+
+	pthread_mutex_lock(&tail->mutex);
+	double pending_lag = 0.0;		// age of the oldest record still waiting
+	if (tail->first != NULL)
+	{
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		pending_lag = elapsed(&tail->first->read_time, &now);
+	}
+	printf("Following %s\n", tail->path);
+	printf("Records applied : %ld , waiting : %ld\n", tail->num_of_applied, tail->num_of_pending);
+	printf("Ingest lag : last %.3f ms , max %.3f ms , oldest waiting %.3f ms\n\n", tail->last_lag * 1e3, tail->max_lag * 1e3, pending_lag * 1e3);
+	pthread_mutex_unlock(&tail->mutex);
+}
+
+void tail_stop(Tail tail)
+{
+	if (tail == NULL)
+		fprintf(stderr, "Error : tail_stop -> tail is NULL\n");
+	assert(tail != NULL);
+
+	if (write(tail->stop_pipe[1], "", 1) == -1)
+		fprintf(stderr, "Error : tail_stop -> write\n");
+	pthread_join(tail->thread, NULL);
+
+	while (tail->first != NULL)
+	{
+		struct batch * next = tail->first->next;
+		free(tail->first->text);
+		free(tail->first);
+		tail->first = next;
+	}
+
+	for (int i = 0; i < tail->num_of_files; i++)
+	{
+		free(tail->files[i].path);
+		free(tail->files[i].partial);
+	}
+	free(tail->files);
+
+	close(tail->inotify_fd);
+	close(tail->stop_pipe[0]);
+	close(tail->stop_pipe[1]);
+	close(tail->ready_pipe[0]);
+	close(tail->ready_pipe[1]);
+	pthread_mutex_destroy(&tail->mutex);
+	free(tail->path);
+	free(tail);
+}
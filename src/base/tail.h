@@ -0,0 +1,16 @@
+/* file : tail.h */
+#pragma once
+#include "monitor.h"
+
+typedef struct tail * Tail;
+
+/* starts following a citizen records file (or every file of a directory) : records appended from now on are read by a background thread, in batches */
+Tail tail_start(const char * path);
+/* returns a descriptor that becomes readable when batches of records are waiting to be applied */
+int tail_fd(Tail tail);
+/* applies all waiting batches of records to the monitor (must be called between queries), returns number of records applied */
+long tail_apply(Tail tail, Monitor monitor);
+/* prints number of applied and waiting records, and the time records waited from being read until being applied */
+void tail_print_stats(Tail tail);
+/* stops following, waiting records are discarded */
+void tail_stop(Tail tail);
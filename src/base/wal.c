@@ -0,0 +1,253 @@
+/* file : wal.c */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include "wal.h"
+#include <assert.h>
+
+#define WAL_BUFFER_SIZE (1 << 16)
+
+/* append-only log of the mutations of the monitor, one text line per mutation.
+   Records are buffered, and a flusher thread writes and syncs them as a group, every group_commit_ms milliseconds.
+   Each record has a sequence number (its lsn), and the caller that appended it waits until a sync covers it */
+struct wal {
+	FILE * file;
+	int fd;
+	int group_commit_ms;
+	long appended_lsn;				// lsn of the last appended record
+	long durable_lsn;				// lsn of the last record known to be on disk
+	bool closing;
+	pthread_t flusher;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	pthread_cond_t durable_cond;	// signaled whenever durable_lsn grows
+};
+
+/* cuts off a partially written last record (left by a crash in the middle of a write), so that new records start on a new line */
+static void truncate_partial_record(int fd)
+{
+	struct stat st;
+	if (fstat(fd, &st) == -1 || st.st_size == 0)
+		return;
+
+	char buffer[4096];
+	off_t end = st.st_size;
+	while (end > 0)
+	{
+		off_t start = (end > (off_t) sizeof(buffer)) ? end - (off_t) sizeof(buffer) : 0;
+		ssize_t bytes = pread(fd, buffer, end - start, start);
+		if (bytes <= 0)
+			return;
+
+		for (ssize_t i = bytes - 1; i >= 0; i--)
+		{
+			if (buffer[i] == '\n')
+			{
+				if (start + i + 1 != st.st_size && ftruncate(fd, start + i + 1) == -1)
+					fprintf(stderr, "Error : wal_open -> ftruncate\n");
+				return;
+			}
+		}
+		end = start;
+	}
+
+	// no complete record at all
+	if (ftruncate(fd, 0) == -1)
+		fprintf(stderr, "Error : wal_open -> ftruncate\n");
+}
+
+/* writes buffered records to the file, and syncs them. Called with the mutex held, which is released during the sync */
+static void flush_records(Wal wal)
+{
+	if (wal->durable_lsn == wal->appended_lsn)
+		return;
+
+	long lsn = wal->appended_lsn;		// records up to here are written by the fflush, and covered by the sync
+	fflush(wal->file);
+
+	pthread_mutex_unlock(&wal->mutex);		// appends can go on (into the buffer) while the disk syncs
+	if (fdatasync(wal->fd) == -1)
+		fprintf(stderr, "Error : wal -> fdatasync\n");
+	pthread_mutex_lock(&wal->mutex);
+
+	if (lsn > wal->durable_lsn)
+	{
+		wal->durable_lsn = lsn;
+		pthread_cond_broadcast(&wal->durable_cond);
+	}
+}
+
+static void * flusher_thread(void * arg)
+{
+	Wal wal = arg;
+
+	pthread_mutex_lock(&wal->mutex);
+	while (!wal->closing)
+	{
+		struct timespec deadline;
+		clock_gettime(CLOCK_REALTIME, &deadline);
+		deadline.tv_sec += wal->group_commit_ms / 1000;
+		deadline.tv_nsec += (long) (wal->group_commit_ms % 1000) * 1000000;
+		if (deadline.tv_nsec >= 1000000000)
+		{
+			deadline.tv_sec++;
+			deadline.tv_nsec -= 1000000000;
+		}
+
+		int rc = 0;
+		while (!wal->closing && rc != ETIMEDOUT)
+			rc = pthread_cond_timedwait(&wal->cond, &wal->mutex, &deadline);
+
+		flush_records(wal);		// everything appended during the interval is committed with a single sync
+	}
+	pthread_mutex_unlock(&wal->mutex);
+
+	return NULL;
+}
+
+Wal wal_open(const char * path, int group_commit_ms)
+{
+	int fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+	if (fd == -1)
+	{
+		fprintf(stderr, "Error : wal_open -> could not open file %s\n", path);
+		return NULL;
+	}
+	truncate_partial_record(fd);
+
+	Wal wal = malloc(sizeof(struct wal));
+	if (wal == NULL)
+		fprintf(stderr, "Error : wal_open -> malloc\n");
+	assert(wal != NULL);
+
+	wal->fd = fd;
+	wal->file = fdopen(fd, "a");
+	if (wal->file == NULL)
+		fprintf(stderr, "Error : wal_open -> fdopen\n");
+	assert(wal->file != NULL);
+	setvbuf(wal->file, NULL, _IOFBF, WAL_BUFFER_SIZE);
+
+	wal->group_commit_ms = (group_commit_ms < 0) ? 0 : group_commit_ms;
+	wal->appended_lsn = 0;
+	wal->durable_lsn = 0;
+	wal->closing = false;
+	pthread_mutex_init(&wal->mutex, NULL);
+	pthread_cond_init(&wal->cond, NULL);
+	pthread_cond_init(&wal->durable_cond, NULL);
+
+	if (wal->group_commit_ms > 0)
+		pthread_create(&wal->flusher, NULL, flusher_thread, wal);
+
+	return wal;
+}
+
+/* waits until given record is on disk : with no group commit interval the caller syncs it itself,
+   otherwise it waits for the next sync of the flusher, which covers all the records appended meanwhile. Called with the mutex held */
+static void wait_durable(Wal wal, long lsn)
+{
+	if (wal->group_commit_ms == 0)
+		flush_records(wal);
+	while (wal->durable_lsn < lsn)
+		pthread_cond_wait(&wal->durable_cond, &wal->mutex);
+}
+
+static void append_insert(Wal wal, char * citizenID, char * firstName, char * lastName, char * country, int age, char * virusName, char * vacc, char * date)
+{
+	fprintf(wal->file, "%s %s %s %s %s %d %s %s", WAL_INSERT, citizenID, firstName, lastName, country, age, virusName, vacc);
+	if (date != NULL)
+		fprintf(wal->file, " %s", date);
+	fputc('\n', wal->file);
+	wal->appended_lsn++;
+}
+
+void wal_log_insert(Wal wal, char * citizenID, char * firstName, char * lastName, char * country, int age, char * virusName, char * vacc, char * date)
+{
+	if (wal == NULL)
+		fprintf(stderr, "Error : wal_log_insert -> wal is NULL\n");
+	assert(wal != NULL);
+
+	// records are logged before they are applied, so the caller returns only once its record is on disk
+	pthread_mutex_lock(&wal->mutex);
+	append_insert(wal, citizenID, firstName, lastName, country, age, virusName, vacc, date);
+	wait_durable(wal, wal->appended_lsn);
+	pthread_mutex_unlock(&wal->mutex);
+}
+
+void wal_append_insert(Wal wal, char * citizenID, char * firstName, char * lastName, char * country, int age, char * virusName, char * vacc, char * date)
+{
+	if (wal == NULL)
+		fprintf(stderr, "Error : wal_append_insert -> wal is NULL\n");
+	assert(wal != NULL);
+
+	pthread_mutex_lock(&wal->mutex);
+	append_insert(wal, citizenID, firstName, lastName, country, age, virusName, vacc, date);
+	pthread_mutex_unlock(&wal->mutex);
+}
+
+void wal_log_vaccinate(Wal wal, char * citizenID, char * firstName, char * lastName, char * country, int age, char * virusName, char * date)
+{
+	if (wal == NULL)
+		fprintf(stderr, "Error : wal_log_vaccinate -> wal is NULL\n");
+	assert(wal != NULL);
+
+	pthread_mutex_lock(&wal->mutex);
+	fprintf(wal->file, "%s %s %s %s %s %d %s %s\n", WAL_VACCINATE, citizenID, firstName, lastName, country, age, virusName, date);
+	wait_durable(wal, ++wal->appended_lsn);
+	pthread_mutex_unlock(&wal->mutex);
+}
+
+void wal_sync(Wal wal)
+{
+	if (wal == NULL)
+		fprintf(stderr, "Error : wal_sync -> wal is NULL\n");
+	assert(wal != NULL);
+
+	pthread_mutex_lock(&wal->mutex);
+	flush_records(wal);
+	pthread_mutex_unlock(&wal->mutex);
+}
+
+void wal_truncate(Wal wal)
+{
+	if (wal == NULL)
+		fprintf(stderr, "Error : wal_truncate -> wal is NULL\n");
+	assert(wal != NULL);
+
+	pthread_mutex_lock(&wal->mutex);
+	fflush(wal->file);		// buffered records are dropped along with the rest, the file is opened for appending so new records start at its beginning
+	if (ftruncate(wal->fd, 0) == -1 || fsync(wal->fd) == -1)
+		fprintf(stderr, "Error : wal_truncate -> ftruncate\n");
+	wal->durable_lsn = wal->appended_lsn;		// the snapshot holds them now
+	pthread_cond_broadcast(&wal->durable_cond);
+	pthread_mutex_unlock(&wal->mutex);
+}
+
+void wal_close(Wal wal)
+{
+	if (wal == NULL)
+		fprintf(stderr, "Error : wal_close -> wal is NULL\n");
+	assert(wal != NULL);
+
+	if (wal->group_commit_ms > 0)
+	{
+		pthread_mutex_lock(&wal->mutex);
+		wal->closing = true;
+		pthread_cond_signal(&wal->cond);
+		pthread_mutex_unlock(&wal->mutex);
+		pthread_join(wal->flusher, NULL);
+	}
+
+	wal_sync(wal);
+	fclose(wal->file);
+	pthread_mutex_destroy(&wal->mutex);
+	pthread_cond_destroy(&wal->cond);
+	pthread_cond_destroy(&wal->durable_cond);
+	free(wal);
+}
@@ -0,0 +1,23 @@
+/* file : wal.h */
+#pragma once
+
+#define WAL_INSERT "INSERT"			// tag of a logged insertCitizenRecord
+#define WAL_VACCINATE "VACCINATE"	// tag of a logged vaccinateNow (with the date it was applied on)
+
+typedef struct wal * Wal;
+
+/* opens (or creates) a write-ahead log for appending. Appended records are synced to disk every group_commit_ms milliseconds (0 : on every append),
+   and wal_log_insert / wal_log_vaccinate return once their record is synced */
+Wal wal_open(const char * path, int group_commit_ms);
+/* appends an insertCitizenRecord mutation to the log */
+void wal_log_insert(Wal wal, char * citizenID, char * firstName, char * lastName, char * country, int age, char * virusName, char * vacc, char * date);
+/* appends a vaccinateNow mutation, applied on given date, to the log */
+void wal_log_vaccinate(Wal wal, char * citizenID, char * firstName, char * lastName, char * country, int age, char * virusName, char * date);
+/* appends an insertCitizenRecord mutation to the log without waiting for its sync, for a batch of mutations that ends with wal_sync */
+void wal_append_insert(Wal wal, char * citizenID, char * firstName, char * lastName, char * country, int age, char * virusName, char * vacc, char * date);
+/* syncs all appended records to disk */
+void wal_sync(Wal wal);
+/* empties the log, once the monitor with all its logged records was saved into a snapshot (the snapshot is the new base of the log) */
+void wal_truncate(Wal wal);
+/* syncs all appended records, and closes the log */
+void wal_close(Wal wal);
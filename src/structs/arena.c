@@ -0,0 +1,105 @@
+/*file : arena.c*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include "arena.h"
+#include <assert.h>
+
+#define ARENA_ALIGNMENT 8
+
+// a large block of memory, blocks of the arena are cut from it one after the other
+struct slab {
+	struct slab * next;		// previously filled slab
+	size_t size;			// usable bytes of the slab
+	size_t used;
+	max_align_t data[];
+};
+
+// data struct for arena
+struct arena {
+	struct slab * current;		// slab blocks are currently cut from (head of the list of all slabs)
+	size_t slab_size;
+	size_t reserved;			// bytes of all slabs
+	size_t used;				// bytes handed out
+	int num_of_slabs;
+};
+
+Arena arena_create(size_t slab_size)
+{
+	Arena arena = malloc(sizeof(struct arena));
+	if (arena == NULL)
+		fprintf(stderr, "Error : arena_create -> malloc\n");
+	assert(arena != NULL);
+
+	arena->current = NULL;
+	arena->slab_size = slab_size;
+	arena->reserved = 0;
+	arena->used = 0;
+	arena->num_of_slabs = 0;
+
+	return arena;
+}
+
+static void new_slab(Arena arena, size_t min_size)
+{
+	size_t size = (min_size > arena->slab_size) ? min_size : arena->slab_size;		// a block larger than a slab gets a slab of its own
+
+	struct slab * slab = malloc(sizeof(struct slab) + size);
+	if (slab == NULL)
+		fprintf(stderr, "Error : arena_alloc -> malloc\n");
+	assert(slab != NULL);
+
+	slab->size = size;
+	slab->used = 0;
+	slab->next = arena->current;
+	arena->current = slab;
+	arena->reserved += sizeof(struct slab) + size;
+	arena->num_of_slabs++;
+}
+
+void * arena_alloc(Arena arena, size_t size)
+{
+	if (arena == NULL)
+		fprintf(stderr, "Error : arena_alloc -> arena is NULL\n");
+	assert(arena != NULL);
+
+	size = (size + ARENA_ALIGNMENT - 1) & ~((size_t) ARENA_ALIGNMENT - 1);
+
+	if (arena->current == NULL || arena->current->used + size > arena->current->size)
+		new_slab(arena, size);		// the rest of the current slab is left unused
+
+	void * block = (char *) arena->current->data + arena->current->used;
+	arena->current->used += size;
+	arena->used += size;
+	return block;
+}
+
+size_t arena_reserved(Arena arena)
+{
+	return arena->reserved;
+}
+
+size_t arena_used(Arena arena)
+{
+	return arena->used;
+}
+
+int arena_slabs(Arena arena)
+{
+	return arena->num_of_slabs;
+}
+
+void arena_destroy(Arena arena)
+{
+	if (arena == NULL)
+		fprintf(stderr, "Error : arena_destroy -> arena is NULL\n");
+	assert(arena != NULL);
+
+	while (arena->current != NULL)
+	{
+		struct slab * next = arena->current->next;
+		free(arena->current);
+		arena->current = next;
+	}
+	free(arena);
+}
@@ -0,0 +1,18 @@
+/*file : arena.h */
+#pragma once
+#include <stddef.h>
+
+typedef struct arena * Arena;
+
+// creates an arena that hands out memory from slabs of given size
+Arena arena_create(size_t slab_size);
+// returns a block of given size (aligned for any type), which lives until the arena is destroyed
+void * arena_alloc(Arena arena, size_t size);
+// returns number of bytes of all the slabs of the arena
+size_t arena_reserved(Arena arena);
+// returns number of bytes handed out by the arena
+size_t arena_used(Arena arena);
+// returns number of slabs of the arena
+int arena_slabs(Arena arena);
+// deletes the arena, releasing all of its slabs (and all blocks handed out) at once
+void arena_destroy(Arena arena);
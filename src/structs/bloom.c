@@ -1,14 +1,33 @@
 /*file : bloom.c*/
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include "bloom.h"
 #include <stdint.h>
 #include <assert.h>
+#include <math.h>
+#include <limits.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_AVX2_KERNEL
+#endif
+
+#define BLOCK_BITS (BLOOM_BLOCK_SIZE * 8)
+#define BLOCK_WORDS (BLOOM_BLOCK_SIZE / 8)
 
 // data struct for bloom filter
 struct bloom_filter {
 	uint8_t * bit_array;
 	unsigned int size;
+	BloomLayout layout;
+	int num_of_hashes;
+	unsigned int num_of_blocks;		// number of blocks of a blocked filter
+	unsigned long capacity;			// number of keys a sub-filter of a scalable filter is sized for (0 if the filter is not scalable)
+	unsigned long count;			// number of keys inserted into the sub-filter
+	double fpr;						// false positive rate the sub-filter is sized for
+	Bloom next;						// sub-filter that follows, larger and of lower false positive rate
+	Bloom last;						// last sub-filter of the chain (of the first one), keys are inserted into it
 };
 
 /* first hash function : djb2*/
@@ -40,36 +59,261 @@ unsigned long hash_i(unsigned char *str, unsigned int i) {
 }
 
 
-Bloom bloom_create(unsigned int bloom_size)
+uint64_t hash_once(unsigned char *str) {
+	uint64_t hash = 14695981039346656037ULL;
+	int c;
+
+	while ((c = *str++)) {
+		hash = (hash ^ c) * 1099511628211ULL;
+	}
+
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdULL;
+	hash ^= hash >> 33;
+	hash *= 0xc4ceb9fe1a85ec53ULL;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+
+void bloom_dimensions(unsigned long num_of_keys, double fpr, unsigned int * bloom_size, int * num_of_hashes)
+{
+	if (num_of_keys == 0)
+		num_of_keys = 1;
+
+	// m = -n ln(p) / ln(2)^2 bits, and k = (m / n) ln(2) hash functions
+	double bits = ceil(-(double) num_of_keys * log(fpr) / (M_LN2 * M_LN2));
+	if (bits > (double) (UINT_MAX / 8) * 8 - BLOOM_BLOCK_SIZE * 8)
+		bits = (double) (UINT_MAX / 8) * 8 - BLOOM_BLOCK_SIZE * 8;		// size in bits has to fit into an unsigned int
+	*bloom_size = (unsigned int) ((bits + 7) / 8);
+
+	int hashes = (int) lround(bits / num_of_keys * M_LN2);
+	*num_of_hashes = (hashes < 1) ? 1 : (hashes > BLOOM_MAX_HASHES) ? BLOOM_MAX_HASHES : hashes;
+}
+
+Bloom bloom_create(unsigned int bloom_size, int num_of_hashes, BloomLayout layout)
 {
 	Bloom bloom = malloc(sizeof(*bloom));	// malloc bloom pointer to the bloom filter structure
 	if (bloom == NULL)
 		fprintf(stderr, "Error : bloom_create -> malloc\n");
 	assert(bloom != NULL);
 
-	bloom->bit_array = malloc(bloom_size * sizeof(uint8_t));	// malloc the bit array to have bloom_size 8-bit integers so total of 8*bloom_size bits
+	if (layout == BLOOM_BLOCKED)		// a blocked filter is made of whole blocks
+		bloom_size = (bloom_size + BLOOM_BLOCK_SIZE - 1) / BLOOM_BLOCK_SIZE * BLOOM_BLOCK_SIZE;
+
+	// the bit array to have bloom_size 8-bit integers so total of 8*bloom_size bits, aligned so that every block is a single cache line
+	bloom->bit_array = aligned_alloc(BLOOM_BLOCK_SIZE, (bloom_size + BLOOM_BLOCK_SIZE - 1) / BLOOM_BLOCK_SIZE * BLOOM_BLOCK_SIZE);
 	if (bloom->bit_array == NULL)
-		fprintf(stderr, "Error : bloom_create -> malloc\n");
+		fprintf(stderr, "Error : bloom_create -> aligned_alloc\n");
 	assert(bloom->bit_array != NULL);
 
 	for (unsigned int i = 0; i < bloom_size; i++)
 		bloom->bit_array[i] = 0;		// initially all bits and hence all bytes of bit array are set to zero
 
 	bloom->size = bloom_size * 8;	// keep the number of bits of the bloom filter
+	bloom->layout = layout;
+	bloom->num_of_hashes = num_of_hashes;
+	bloom->num_of_blocks = bloom_size / BLOOM_BLOCK_SIZE;
+	bloom->capacity = 0;
+	bloom->count = 0;
+	bloom->fpr = 0;
+	bloom->next = NULL;
+	bloom->last = bloom;
 
 	return bloom;
 
 }
 
-bool bloom_check(Bloom bloom, unsigned char * string)
+/* creates a sub-filter of a scalable filter, for given number of keys at given false positive rate */
+static Bloom sub_filter_create(unsigned long capacity, double fpr, BloomLayout layout)
 {
-	if (bloom == NULL)
-		fprintf(stderr, "Error : bloom_check -> bloom is NULL\n");
-	assert(bloom != NULL);
+	unsigned int bloom_size;
+	int num_of_hashes;
+	bloom_dimensions(capacity, fpr, &bloom_size, &num_of_hashes);
+
+	Bloom bloom = bloom_create(bloom_size, num_of_hashes, layout);
+	bloom_set_scalable(bloom, capacity, 0, fpr);
+	return bloom;
+}
+
+Bloom bloom_create_scalable(unsigned long num_of_keys, double fpr, BloomLayout layout)
+{
+	// the rates of the sub-filters are fpr (1 - r), fpr (1 - r) r, fpr (1 - r) r^2, ... so that the rate of any of them being a false positive is at most fpr
+	return sub_filter_create((num_of_keys == 0) ? 1 : num_of_keys, fpr * (1 - BLOOM_TIGHTENING), layout);
+}
+
+void bloom_set_scalable(Bloom bloom, unsigned long capacity, unsigned long count, double fpr)
+{
+	bloom->capacity = capacity;
+	bloom->count = count;
+	bloom->fpr = fpr;
+}
+
+void bloom_chain(Bloom bloom, Bloom sub_filter)
+{
+	bloom->last->next = sub_filter;		// the sub-filter is complete before it is linked, so the chain can be checked while it grows
+	bloom->last = sub_filter;
+}
+
+Bloom bloom_next(Bloom bloom)
+{
+	return bloom->next;
+}
+
+unsigned long bloom_capacity(Bloom bloom)
+{
+	return bloom->capacity;
+}
+
+unsigned long bloom_count(Bloom bloom)
+{
+	return bloom->count;
+}
+
+double bloom_fpr(Bloom bloom)
+{
+	return bloom->fpr;
+}
+
+int bloom_filters(Bloom bloom)
+{
+	int num_of_filters = 0;
+	for ( ; bloom != NULL; bloom = bloom->next)
+		num_of_filters++;
+	return num_of_filters;
+}
+
+unsigned long bloom_memory(Bloom bloom)
+{
+	unsigned long bytes = 0;
+	for ( ; bloom != NULL; bloom = bloom->next)
+		bytes += bloom->size / 8;
+	return bytes;
+}
+
+BloomLayout bloom_layout(Bloom bloom)
+{
+	return bloom->layout;
+}
+
+int bloom_hashes(Bloom bloom)
+{
+	return bloom->num_of_hashes;
+}
+
+/* number of bits set in given bytes */
+static unsigned long count_bits(const uint8_t * bytes, unsigned int size)
+{
+	unsigned long count = 0;
+	for (unsigned int i = 0; i < size; i++)
+		count += __builtin_popcount(bytes[i]);
+	return count;
+}
+
+double bloom_fill_ratio(Bloom bloom)
+{
+	unsigned long set = 0, bits = 0;
+	for ( ; bloom != NULL; bloom = bloom->next)
+	{
+		set += count_bits(bloom->bit_array, bloom->size / 8);
+		bits += bloom->size;
+	}
+	return (double) set / bits;
+}
+
+/* estimated false positive rate of a single (sub-)filter */
+static double filter_estimated_fpr(Bloom bloom)
+{
+	if (bloom->layout == BLOOM_CLASSIC)		// all k bits of a key that is not in the filter are set with probability fill^k
+		return pow(bloom_fill_ratio(bloom), bloom->num_of_hashes);
+
+	// a key that is not in the filter only probes its own block, so it is a false positive with the probability of the fill of that block
+	double fpr = 0;
+	for (unsigned int i = 0; i < bloom->num_of_blocks; i++)
+		fpr += pow((double) count_bits(bloom->bit_array + i * BLOOM_BLOCK_SIZE, BLOOM_BLOCK_SIZE) / BLOCK_BITS, bloom->num_of_hashes);
+	return fpr / bloom->num_of_blocks;
+}
+
+double bloom_estimated_fpr(Bloom bloom)
+{
+	// a key is a false positive of the filter unless it is a true negative of every sub-filter
+	double true_negative = 1;
+	for ( ; bloom != NULL; bloom = bloom->next)
+		true_negative *= 1 - filter_estimated_fpr(bloom);
+	return 1 - true_negative;
+}
+
+const char * bloom_layout_name(BloomLayout layout)
+{
+	return (layout == BLOOM_BLOCKED) ? "blocked" : "classic";
+}
+
+int bloom_layout_parse(const char * name)
+{
+	if (!strcmp(name, "classic"))
+		return BLOOM_CLASSIC;
+	else if (!strcmp(name, "blocked"))
+		return BLOOM_BLOCKED;
+	return -1;
+}
+
+/* returns the block of given hash, and sets in mask the bits of the block that belong to it */
+static uint64_t * block_mask(Bloom bloom, uint64_t hash, uint64_t * mask)
+{
+	// the upper half of the hash picks the block (multiply and shift instead of a modulo), the lower half the bits in it
+	uint64_t * block = (uint64_t *) (bloom->bit_array + (((hash >> 32) * bloom->num_of_blocks) >> 32) * BLOOM_BLOCK_SIZE);
+
+	// double hashing inside the block : an odd step visits k different bits of the BLOCK_BITS (a power of 2)
+	unsigned int pos = hash % BLOCK_BITS;
+	unsigned int step = ((hash / BLOCK_BITS) % BLOCK_BITS) | 1;
+	memset(mask, 0, BLOOM_BLOCK_SIZE);
+	for (int i = 0; i < bloom->num_of_hashes; i++)
+	{
+		mask[pos / 64] |= 1ULL << (pos % 64);
+		pos = (pos + step) % BLOCK_BITS;
+	}
+	return block;
+}
+
+#ifdef HAVE_AVX2_KERNEL
+/* checks that all bits of the mask are set in the block, 256 bits at a time */
+__attribute__((target("avx2")))
+static bool block_check_avx2(const uint64_t * block, const uint64_t * mask)
+{
+	__m256i missing = _mm256_setzero_si256();
+	for (int i = 0; i < BLOCK_WORDS; i += 4)		// bits of the mask that are not set in the block
+		missing = _mm256_or_si256(missing, _mm256_andnot_si256(_mm256_load_si256((const __m256i *) &block[i]), _mm256_loadu_si256((const __m256i *) &mask[i])));
+	return _mm256_testz_si256(missing, missing);
+}
+#endif
+
+/* checks that all bits of the mask are set in the block */
+static bool block_check(const uint64_t * block, const uint64_t * mask)
+{
+#ifdef HAVE_AVX2_KERNEL
+	if (__builtin_cpu_supports("avx2"))
+		return block_check_avx2(block, mask);
+#endif
+	uint64_t missing = 0;
+	for (int i = 0; i < BLOCK_WORDS; i++)
+		missing |= mask[i] & ~block[i];
+	return missing == 0;
+}
+
+/* checks if a given string is in a single (sub-)filter, hash is the hash_once of the string for a blocked filter */
+static bool filter_check(Bloom bloom, unsigned char * string, uint64_t hash)
+{
+	if (bloom->layout == BLOOM_BLOCKED)
+	{
+		// one pass over the string and one cache line of the bit array, instead of 2*K passes and K cache lines
+		uint64_t mask[BLOCK_WORDS];
+		uint64_t * block = block_mask(bloom, hash, mask);
+		return block_check(block, mask);
+	}
 
 	bool maybe_in = true;	// initially assume that the given object may be into the bloom filter (either positive or false positive)
 
-	for (int i = 0; i < K; i++)		// for all k hash functions
+	for (int i = 0; i < bloom->num_of_hashes; i++)		// for all k hash functions
 	{
 		unsigned long pos = hash_i(string, i) % bloom->size;	// get bit position in bit array as returned from hash function
 		// this following line isolates the 8-bit number where our bit of interest is found (pos/8)
@@ -86,13 +330,65 @@ bool bloom_check(Bloom bloom, unsigned char * string)
 	return maybe_in;
 }
 
-void bloom_insert(Bloom bloom, unsigned char * string)
+bool bloom_check(Bloom bloom, unsigned char * string)
 {
 	if (bloom == NULL)
-		fprintf(stderr, "Error : bloom_insert -> bloom is NULL\n");
+		fprintf(stderr, "Error : bloom_check -> bloom is NULL\n");
+	assert(bloom != NULL);
+
+	// the string is hashed once for all the sub-filters (blocked or not, all sub-filters of a scalable filter are of the same layout)
+	return bloom_check_hash(bloom, string, (bloom->layout == BLOOM_BLOCKED) ? hash_once(string) : 0);
+}
+
+bool bloom_check_hash(Bloom bloom, unsigned char * string, uint64_t hash)
+{
+	if (bloom == NULL)
+		fprintf(stderr, "Error : bloom_check_hash -> bloom is NULL\n");
+	assert(bloom != NULL);
+
+	for ( ; bloom != NULL; bloom = bloom->next)
+	{
+		if (filter_check(bloom, string, hash))
+			return true;
+	}
+	return false;
+}
+
+void bloom_prefetch(Bloom bloom, unsigned char * string, uint64_t hash)
+{
+	if (bloom == NULL)
+		fprintf(stderr, "Error : bloom_prefetch -> bloom is NULL\n");
 	assert(bloom != NULL);
 
-	for (int i = 0; i < K; i++)	// for all k hash functions
+	if (bloom->layout == BLOOM_BLOCKED)		// the single block of the string, in every sub-filter
+	{
+		for ( ; bloom != NULL; bloom = bloom->next)
+			__builtin_prefetch(bloom->bit_array + (((hash >> 32) * bloom->num_of_blocks) >> 32) * BLOOM_BLOCK_SIZE);
+		return;
+	}
+
+	// the K bits of a classic filter are djb2 + i*sdbm + i*i (see hash_i), each string hash is computed once for all of them
+	unsigned long first = djb2(string), second = sdbm(string);
+	for ( ; bloom != NULL; bloom = bloom->next)
+	{
+		for (unsigned long i = 0; i < (unsigned long) bloom->num_of_hashes; i++)
+			__builtin_prefetch(bloom->bit_array + ((first + i * second + i * i) % bloom->size) / 8);
+	}
+}
+
+/* inserts given string into a single (sub-)filter */
+static void filter_insert(Bloom bloom, unsigned char * string)
+{
+	if (bloom->layout == BLOOM_BLOCKED)
+	{
+		uint64_t mask[BLOCK_WORDS];
+		uint64_t * block = block_mask(bloom, hash_once(string), mask);
+		for (int i = 0; i < BLOCK_WORDS; i++)
+			block[i] |= mask[i];
+		return;
+	}
+
+	for (int i = 0; i < bloom->num_of_hashes; i++)	// for all k hash functions
 	{
 		unsigned long pos = hash_i(string, i) % bloom->size;	// get bit position in bit array as returned from hash function
 		// set bit at position by doing a bitwise or of the 8-bit number where our bit of interest is found
@@ -103,12 +399,55 @@ void bloom_insert(Bloom bloom, unsigned char * string)
 
 }
 
+void bloom_insert(Bloom bloom, unsigned char * string)
+{
+	if (bloom == NULL)
+		fprintf(stderr, "Error : bloom_insert -> bloom is NULL\n");
+	assert(bloom != NULL);
+
+	// a full sub-filter would go past its false positive rate, so a larger one of lower rate is added, and the keys from now on go into it
+	Bloom last = bloom->last;
+	if (last->capacity != 0 && last->count >= last->capacity)
+	{
+		last = sub_filter_create(last->capacity * BLOOM_GROWTH, last->fpr * BLOOM_TIGHTENING, last->layout);
+		bloom_chain(bloom, last);
+	}
+
+	filter_insert(last, string);
+	last->count++;
+}
+
+const uint8_t * bloom_bits(Bloom bloom, unsigned int * bloom_size)
+{
+	if (bloom == NULL)
+		fprintf(stderr, "Error : bloom_bits -> bloom is NULL\n");
+	assert(bloom != NULL);
+
+	*bloom_size = bloom->size / 8;
+	return bloom->bit_array;
+}
+
+void bloom_load(Bloom bloom, const uint8_t * bits, unsigned int bloom_size)
+{
+	if (bloom == NULL)
+		fprintf(stderr, "Error : bloom_load -> bloom is NULL\n");
+	assert(bloom != NULL);
+
+	if (bloom_size != bloom->size / 8)
+		fprintf(stderr, "Error : bloom_load -> size mismatch\n");
+	assert(bloom_size == bloom->size / 8);
+
+	memcpy(bloom->bit_array, bits, bloom_size);
+}
+
 void bloom_destroy(Bloom bloom)
 {
 	if (bloom == NULL)
 		fprintf(stderr, "Error : bloom_delete -> bloom is NULL\n");
 	assert(bloom != NULL);
 
+	if (bloom->next != NULL)
+		bloom_destroy(bloom->next);		// free the sub-filters that follow
 	free(bloom->bit_array);		// free bit array of bloom filter
 	free(bloom);		// free the pointer to the bloom filter structure itself
 
@@ -1,22 +1,73 @@
 /*file : bloom.h*/
 #pragma once
 #include <stdbool.h>
+#include <stdint.h>
 
-#define K 16 // the number of hash functions the filter uses
+#define K 16 // the number of hash functions of a filter of given size
+#define BLOOM_MAX_HASHES 32 // the number of hash functions of a filter sized from a false positive rate is at most this
+#define BLOOM_BLOCK_SIZE 64 // size in bytes of a block of a blocked bloom filter (a cache line)
+#define BLOOM_GROWTH 2 // each sub-filter of a scalable bloom filter takes this many times the keys of the previous one
+#define BLOOM_TIGHTENING 0.5 // and has this many times its false positive rate
 
 typedef struct bloom_filter* Bloom;
 
+/* layout of the bits of a bloom filter */
+typedef enum {
+	BLOOM_CLASSIC,		// the K bits of a string are anywhere in the bit array, each given by one of the K hash functions
+	BLOOM_BLOCKED		// the string is hashed once, and all its K bits are within a single block of the bit array
+} BloomLayout;
+
 /* first hash function : djb2*/
 unsigned long djb2(unsigned char *str);
 /* second hash function : sdbm*/
 unsigned long sdbm(unsigned char *str);
 /* Return the result of the Kth hash function. This function uses djb2 and sdbm. */
 unsigned long hash_i(unsigned char *str, unsigned int i);
-/* creates a bloom filter of given size, returns a pointer to the structure */
-Bloom bloom_create(unsigned int bloom_size);
+/* single pass 64 bit hash function (used by the blocked layout) : FNV-1a, with the murmur3 finalizer to mix its bits*/
+uint64_t hash_once(unsigned char *str);
+/* computes the size in bytes and number of hash functions of the smallest bloom filter of given number of keys and false positive rate */
+void bloom_dimensions(unsigned long num_of_keys, double fpr, unsigned int * bloom_size, int * num_of_hashes);
+/* creates a bloom filter of given size in bytes (rounded up to whole blocks for a blocked filter), number of hash functions and layout, returns a pointer to the structure */
+Bloom bloom_create(unsigned int bloom_size, int num_of_hashes, BloomLayout layout);
+/* creates a scalable bloom filter of given layout : a chain of sub-filters, where a larger one is added whenever the last one is full, so that its false positive
+   rate stays below the given one however many keys are inserted. The first sub-filter is sized for given number of keys */
+Bloom bloom_create_scalable(unsigned long num_of_keys, double fpr, BloomLayout layout);
+/* makes the bloom filter a sub-filter of a scalable filter, for given number of keys (of which count are inserted) at given false positive rate (used to restore a scalable filter) */
+void bloom_set_scalable(Bloom bloom, unsigned long capacity, unsigned long count, double fpr);
+/* appends given sub-filter to the (scalable) bloom filter */
+void bloom_chain(Bloom bloom, Bloom sub_filter);
+/* returns the sub-filter that follows the bloom filter in its scalable filter (NULL if there is none) */
+Bloom bloom_next(Bloom bloom);
+/* returns the number of keys the (sub-)filter is sized for (0 if the filter is not scalable), the number of keys inserted into it and its false positive rate */
+unsigned long bloom_capacity(Bloom bloom);
+unsigned long bloom_count(Bloom bloom);
+double bloom_fpr(Bloom bloom);
+/* returns the number of (sub-)filters and the size in bytes of all of them */
+int bloom_filters(Bloom bloom);
+unsigned long bloom_memory(Bloom bloom);
+/* returns the layout of the bloom filter */
+BloomLayout bloom_layout(Bloom bloom);
+/* returns the number of hash functions of the bloom filter */
+int bloom_hashes(Bloom bloom);
+/* returns the ratio of the bits of the bloom filter (of all of its sub-filters) that are set */
+double bloom_fill_ratio(Bloom bloom);
+/* returns the false positive rate of the bloom filter (of any of its sub-filters), as estimated from the bits that are set */
+double bloom_estimated_fpr(Bloom bloom);
+/* returns the name of given layout ("classic" or "blocked") */
+const char * bloom_layout_name(BloomLayout layout);
+/* returns the layout of given name, -1 if there is no such layout */
+int bloom_layout_parse(const char * name);
 /* checks if a given object-string is in bloom filter */
 bool bloom_check(Bloom bloom, unsigned char * string);
+/* checks if a given object-string, already hashed by hash_once (the hash is only used by a blocked filter), is in bloom filter */
+bool bloom_check_hash(Bloom bloom, unsigned char * string, uint64_t hash);
+/* prefetches the bits of the bloom filter that a later check of given object-string (and its hash_once) reads, so that the checks of many strings overlap their cache misses */
+void bloom_prefetch(Bloom bloom, unsigned char * string, uint64_t hash);
 /* inserts given object-string into bloom filter */
 void bloom_insert(Bloom bloom, unsigned char * string);
-/* deletes bloom filter data structure */
+/* returns the bit array of the bloom filter (not of the sub-filters that follow it), and its size in bytes */
+const uint8_t * bloom_bits(Bloom bloom, unsigned int * bloom_size);
+/* overwrites the bit array of the bloom filter with given bits (of the same size in bytes) */
+void bloom_load(Bloom bloom, const uint8_t * bits, unsigned int bloom_size);
+/* deletes bloom filter data structure (and the sub-filters that follow it) */
 void bloom_destroy(Bloom bloom);
@@ -0,0 +1,205 @@
+/*file : cuckoo.c*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "cuckoo.h"
+#include <assert.h>
+
+#define MAX_KICKS 500 // an insertion gives up after relocating this many fingerprints
+
+// data struct for cuckoo filter
+struct cuckoo_filter {
+	uint16_t (* buckets)[CUCKOO_BUCKET_SIZE];	// fingerprints of the keys, 0 is an empty slot
+	unsigned long num_of_buckets;
+	unsigned long capacity;
+	unsigned long count;
+	uint16_t victim;							// fingerprint that found no slot when the filter filled up (0 if none)
+	unsigned long victim_bucket;
+	unsigned int seed;							// state of the random generator that picks the fingerprints to relocate
+};
+
+/* a fingerprint is the lower 16 bits of the hash, and never 0 (which marks an empty slot) */
+static uint16_t fingerprint(uint64_t hash)
+{
+	uint16_t fp = hash & 0xFFFF;
+	return (fp == 0) ? 1 : fp;
+}
+
+/* first bucket of a key, from the upper half of its hash (multiply and shift instead of a modulo) */
+static unsigned long first_bucket(Cuckoo cuckoo, uint64_t hash)
+{
+	return ((hash >> 32) * cuckoo->num_of_buckets) >> 32;
+}
+
+/* the other bucket of a fingerprint : (h(fp) - bucket) mod buckets, so that applying it twice gives back the bucket, for any number of buckets */
+static unsigned long alt_bucket(Cuckoo cuckoo, unsigned long bucket, uint16_t fp)
+{
+	unsigned long fp_hash = ((uint64_t) (uint32_t) (fp * 0x9E3779B1u) * cuckoo->num_of_buckets) >> 32;
+	return (fp_hash + cuckoo->num_of_buckets - bucket) % cuckoo->num_of_buckets;
+}
+
+Cuckoo cuckoo_create(unsigned long num_of_keys)
+{
+	Cuckoo cuckoo = malloc(sizeof(*cuckoo));
+	if (cuckoo == NULL)
+		fprintf(stderr, "Error : cuckoo_create -> malloc\n");
+	assert(cuckoo != NULL);
+
+	cuckoo->num_of_buckets = (unsigned long) (num_of_keys / (CUCKOO_BUCKET_SIZE * CUCKOO_LOAD)) + 1;
+	cuckoo->buckets = calloc(cuckoo->num_of_buckets, sizeof(*cuckoo->buckets));		// all slots are initially empty
+	if (cuckoo->buckets == NULL)
+		fprintf(stderr, "Error : cuckoo_create -> calloc\n");
+	assert(cuckoo->buckets != NULL);
+
+	cuckoo->capacity = num_of_keys;
+	cuckoo->count = 0;
+	cuckoo->victim = 0;
+	cuckoo->victim_bucket = 0;
+	cuckoo->seed = (unsigned int) rand();
+
+	return cuckoo;
+}
+
+/* puts fingerprint into an empty slot of given bucket, returns false if the bucket is full */
+static bool bucket_insert(Cuckoo cuckoo, unsigned long bucket, uint16_t fp)
+{
+	for (int i = 0; i < CUCKOO_BUCKET_SIZE; i++)
+	{
+		if (cuckoo->buckets[bucket][i] == 0)
+		{
+			cuckoo->buckets[bucket][i] = fp;
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool bucket_contains(Cuckoo cuckoo, unsigned long bucket, uint16_t fp)
+{
+	for (int i = 0; i < CUCKOO_BUCKET_SIZE; i++)
+	{
+		if (cuckoo->buckets[bucket][i] == fp)
+			return true;
+	}
+	return false;
+}
+
+bool cuckoo_insert(Cuckoo cuckoo, uint64_t hash)
+{
+	if (cuckoo == NULL)
+		fprintf(stderr, "Error : cuckoo_insert -> cuckoo is NULL\n");
+	assert(cuckoo != NULL);
+
+	if (cuckoo->victim != 0)		// the filter is full
+		return false;
+
+	uint16_t fp = fingerprint(hash);
+	unsigned long bucket = first_bucket(cuckoo, hash);
+	cuckoo->count++;
+	if (bucket_insert(cuckoo, bucket, fp) || bucket_insert(cuckoo, (bucket = alt_bucket(cuckoo, bucket, fp)), fp))
+		return true;
+
+	// both buckets are full : a random fingerprint of the bucket is moved to its other bucket, and the same is repeated for it if that one is full too
+	for (int kick = 0; kick < MAX_KICKS; kick++)
+	{
+		int slot = rand_r(&cuckoo->seed) % CUCKOO_BUCKET_SIZE;
+		uint16_t moved = cuckoo->buckets[bucket][slot];
+		cuckoo->buckets[bucket][slot] = fp;
+		fp = moved;
+		bucket = alt_bucket(cuckoo, bucket, fp);
+		if (bucket_insert(cuckoo, bucket, fp))
+			return true;
+	}
+
+	// the last fingerprint moved out is kept aside, so that no key is lost, and the filter takes no more keys
+	cuckoo->victim = fp;
+	cuckoo->victim_bucket = bucket;
+	return true;
+}
+
+bool cuckoo_check(Cuckoo cuckoo, uint64_t hash)
+{
+	if (cuckoo == NULL)
+		fprintf(stderr, "Error : cuckoo_check -> cuckoo is NULL\n");
+	assert(cuckoo != NULL);
+
+	// a key can only be in its two buckets : two cache lines at most, whatever the false positive rate
+	uint16_t fp = fingerprint(hash);
+	unsigned long bucket = first_bucket(cuckoo, hash);
+	unsigned long other = alt_bucket(cuckoo, bucket, fp);
+	if (bucket_contains(cuckoo, bucket, fp) || bucket_contains(cuckoo, other, fp))
+		return true;
+	return cuckoo->victim == fp && (cuckoo->victim_bucket == bucket || cuckoo->victim_bucket == other);
+}
+
+void cuckoo_prefetch(Cuckoo cuckoo, uint64_t hash)
+{
+	if (cuckoo == NULL)
+		fprintf(stderr, "Error : cuckoo_prefetch -> cuckoo is NULL\n");
+	assert(cuckoo != NULL);
+
+	unsigned long bucket = first_bucket(cuckoo, hash);
+	__builtin_prefetch(cuckoo->buckets[bucket]);
+	__builtin_prefetch(cuckoo->buckets[alt_bucket(cuckoo, bucket, fingerprint(hash))]);
+}
+
+/* removes fingerprint from given bucket, returns false if it is not there */
+static bool bucket_delete(Cuckoo cuckoo, unsigned long bucket, uint16_t fp)
+{
+	for (int i = 0; i < CUCKOO_BUCKET_SIZE; i++)
+	{
+		if (cuckoo->buckets[bucket][i] == fp)
+		{
+			cuckoo->buckets[bucket][i] = 0;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool cuckoo_delete(Cuckoo cuckoo, uint64_t hash)
+{
+	if (cuckoo == NULL)
+		fprintf(stderr, "Error : cuckoo_delete -> cuckoo is NULL\n");
+	assert(cuckoo != NULL);
+
+	uint16_t fp = fingerprint(hash);
+	unsigned long bucket = first_bucket(cuckoo, hash);
+	unsigned long other = alt_bucket(cuckoo, bucket, fp);
+	if (cuckoo->victim == fp && (cuckoo->victim_bucket == bucket || cuckoo->victim_bucket == other))
+		cuckoo->victim = 0;
+	else if (!bucket_delete(cuckoo, bucket, fp) && !bucket_delete(cuckoo, other, fp))
+		return false;
+	cuckoo->count--;
+
+	// a slot was freed, so the fingerprint kept aside may fit into one of its buckets now
+	if (cuckoo->victim != 0 && (bucket_insert(cuckoo, cuckoo->victim_bucket, cuckoo->victim) ||
+		bucket_insert(cuckoo, alt_bucket(cuckoo, cuckoo->victim_bucket, cuckoo->victim), cuckoo->victim)))
+		cuckoo->victim = 0;
+	return true;
+}
+
+unsigned long cuckoo_capacity(Cuckoo cuckoo)
+{
+	return cuckoo->capacity;
+}
+
+unsigned long cuckoo_count(Cuckoo cuckoo)
+{
+	return cuckoo->count;
+}
+
+unsigned long cuckoo_memory(Cuckoo cuckoo)
+{
+	return cuckoo->num_of_buckets * sizeof(*cuckoo->buckets);
+}
+
+void cuckoo_destroy(Cuckoo cuckoo)
+{
+	if (cuckoo == NULL)
+		fprintf(stderr, "Error : cuckoo_destroy -> cuckoo is NULL\n");
+	assert(cuckoo != NULL);
+
+	free(cuckoo->buckets);
+	free(cuckoo);
+}
@@ -0,0 +1,28 @@
+/*file : cuckoo.h*/
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+#define CUCKOO_BUCKET_SIZE 4 // fingerprints per bucket
+#define CUCKOO_LOAD 0.9 // a filter is created with room for its keys at this load factor
+
+typedef struct cuckoo_filter* Cuckoo;
+
+/* creates a cuckoo filter of 16 bit fingerprints, with room for given number of keys, returns a pointer to the structure */
+Cuckoo cuckoo_create(unsigned long num_of_keys);
+/* inserts the key of given 64 bit hash, returns false if the filter is full (then the key is not inserted) */
+bool cuckoo_insert(Cuckoo cuckoo, uint64_t hash);
+/* checks if the key of given 64 bit hash may be in the filter */
+bool cuckoo_check(Cuckoo cuckoo, uint64_t hash);
+/* prefetches the two buckets a later check of the key of given 64 bit hash reads */
+void cuckoo_prefetch(Cuckoo cuckoo, uint64_t hash);
+/* deletes the key of given 64 bit hash (which must have been inserted), returns false if it is not in the filter */
+bool cuckoo_delete(Cuckoo cuckoo, uint64_t hash);
+/* returns the number of keys the filter was created for */
+unsigned long cuckoo_capacity(Cuckoo cuckoo);
+/* returns the number of keys in the filter */
+unsigned long cuckoo_count(Cuckoo cuckoo);
+/* returns the size in bytes of the table of the filter */
+unsigned long cuckoo_memory(Cuckoo cuckoo);
+/* deletes cuckoo filter data structure */
+void cuckoo_destroy(Cuckoo cuckoo);
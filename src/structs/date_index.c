@@ -0,0 +1,147 @@
+/*file : date_index.c*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "date_index.h"
+#include <assert.h>
+
+#define FEW_UNSORTED 16		// up to this many dates added out of order are moved into place one by one, more are sorted all together
+
+// data struct for date index : a sorted array of dates, the number of dates in a range is the distance between its two ends
+struct date_index {
+	Date * dates;
+	int size;
+	int capacity;
+	int sorted;			// dates[0 .. sorted-1] are in ascending order, dates after them are not sorted yet
+};
+
+DateIndex date_index_create(void)
+{
+	DateIndex index = malloc(sizeof(struct date_index));
+	if (index == NULL)
+		fprintf(stderr, "Error : date_index_create -> malloc\n");
+	assert(index != NULL);
+
+	index->dates = NULL;
+	index->size = 0;
+	index->capacity = 0;
+	index->sorted = 0;
+
+	return index;
+}
+
+void date_index_add(DateIndex index, Date date)
+{
+	if (index == NULL)
+		fprintf(stderr, "Error : date_index_add -> index is NULL\n");
+	assert(index != NULL);
+
+	if (index->size == index->capacity)
+	{
+		index->capacity = (index->capacity == 0) ? 16 : 2 * index->capacity;
+		index->dates = realloc(index->dates, index->capacity * sizeof(Date));
+		if (index->dates == NULL)
+			fprintf(stderr, "Error : date_index_add -> realloc\n");
+		assert(index->dates != NULL);
+	}
+
+	// a date not before the last one keeps the index sorted (the usual case for vaccinations of today)
+	if (index->sorted == index->size && (index->size == 0 || date >= index->dates[index->size - 1]))
+		index->sorted++;
+	index->dates[index->size++] = date;
+}
+
+// returns position of the first date of dates[0 .. sorted-1] that is not before given date
+static int lower_bound(DateIndex index, int sorted, Date date)
+{
+	int low = 0, high = sorted;
+	while (low < high)
+	{
+		int mid = low + (high - low) / 2;
+		if (index->dates[mid] < date)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return low;
+}
+
+static int date_cmp(const void * a, const void * b)
+{
+	Date date_a = *(const Date *) a;
+	Date date_b = *(const Date *) b;
+	return (date_a > date_b) - (date_a < date_b);
+}
+
+void date_index_sort(DateIndex index)
+{
+	if (index == NULL)
+		fprintf(stderr, "Error : date_index_sort -> index is NULL\n");
+	assert(index != NULL);
+
+	if (index->sorted == index->size)
+		return;
+
+	if (index->size - index->sorted > FEW_UNSORTED)
+		qsort(index->dates, index->size, sizeof(Date), date_cmp);
+	else
+	{
+		for (int sorted = index->sorted; sorted < index->size; sorted++)
+		{
+			Date date = index->dates[sorted];
+			int position = lower_bound(index, sorted, date);
+			memmove(&index->dates[position + 1], &index->dates[position], (sorted - position) * sizeof(Date));
+			index->dates[position] = date;
+		}
+	}
+	// stored once the dates are in place, so that date_index_sorted of another thread sees them sorted
+	__atomic_store_n(&index->sorted, index->size, __ATOMIC_RELEASE);
+}
+
+bool date_index_sorted(DateIndex index)
+{
+	if (index == NULL)
+		fprintf(stderr, "Error : date_index_sorted -> index is NULL\n");
+	assert(index != NULL);
+
+	return __atomic_load_n(&index->sorted, __ATOMIC_ACQUIRE) == index->size;
+}
+
+int date_index_remove(DateIndex index, Date date)
+{
+	if (index == NULL)
+		fprintf(stderr, "Error : date_index_remove -> index is NULL\n");
+	assert(index != NULL);
+
+	date_index_sort(index);
+	int position = lower_bound(index, index->sorted, date);
+	if (position == index->size || index->dates[position] != date)
+		return 0;
+
+	memmove(&index->dates[position], &index->dates[position + 1], (index->size - position - 1) * sizeof(Date));
+	index->size--;
+	index->sorted--;
+	return 1;
+}
+
+int date_index_count(DateIndex index, Date from, Date to)
+{
+	if (index == NULL)
+		fprintf(stderr, "Error : date_index_count -> index is NULL\n");
+	assert(index != NULL);
+
+	date_index_sort(index);
+	if (from > to)
+		return 0;
+	return lower_bound(index, index->sorted, to + 1) - lower_bound(index, index->sorted, from);
+}
+
+void date_index_destroy(DateIndex index)
+{
+	if (index == NULL)
+		fprintf(stderr, "Error : date_index_destroy -> index is NULL\n");
+	assert(index != NULL);
+
+	free(index->dates);
+	free(index);
+}
@@ -0,0 +1,21 @@
+/*file : date_index.h */
+#pragma once
+#include <stdbool.h>
+#include "date.h"
+
+typedef struct date_index * DateIndex;
+
+// creates an empty index of dates
+DateIndex date_index_create(void);
+// adds a date to the index. Dates are best added in ascending order, any other order is sorted by the next count
+void date_index_add(DateIndex index, Date date);
+// removes one occurrence of a date from the index (returns 0 if the date is not in the index)
+int date_index_remove(DateIndex index, Date date);
+// sorts the dates added out of order since the last sort
+void date_index_sort(DateIndex index);
+// returns true if no date was added out of order since the last sort (safe to call while another thread sorts)
+bool date_index_sorted(DateIndex index);
+// returns number of dates of the index in [from, to], with two binary searches
+int date_index_count(DateIndex index, Date from, Date to);
+// deletes the index
+void date_index_destroy(DateIndex index);
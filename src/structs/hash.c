@@ -1,19 +1,36 @@
 /*file : hash.c*/
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <stdint.h>
 #include "hash.h"
-#include "list.h"
 #include "items.h"
 #include <assert.h>
 
 #define MAX_LOAD_FACTOR 0.75
+#define MIGRATE_SLOTS 8			// slots of the previous table moved into the new one on every insert, while rehashing
+#define MIN_CAPACITY 8
+
+/* a slot of the open addressing table : the full hash and the key are kept inline, so that probing
+   compares hashes (and only on a match, keys) without touching the entries themselves.
+   In the citizens table the hash is the integer key of the citizen id itself, so a matching hash is a match */
+struct slot {
+	unsigned long hash;
+	char * key;			// NULL if slot is empty
+	void * value;
+};
 
 // data struct for hash table
 struct hash_table {
-	List *table;		// hash table implemented as an array of linked lists
-	int size;			// number of elements added
-	int capacity;		// number of buckets
-	int type;			// 0 : table of lists of citizens info nodes. 1: table of lists of virus info nodes 2 : table of lists of countries info nodes
+	struct slot *table;		// open addressing table (robin hood linear probing), capacity is a power of 2
+	int size;				// number of elements added
+	int capacity;			// number of slots
+	int type;				// 0 : table of citizens info nodes. 1: table of virus info nodes 2 : table of countries info nodes
+	void **entries;			// all elements, densely, in insertion order (used for iteration)
+	int entries_capacity;
+	struct slot *old_table;	// previous (half size) table while rehashing, NULL otherwise
+	int old_capacity;
+	int migrated;			// slots of old_table before this index have already been moved into table
 };
 
 unsigned long hash_function(unsigned char *str) {
@@ -25,6 +42,28 @@ unsigned long hash_function(unsigned char *str) {
 	return hash;
 }
 
+// home slot of given hash : djb2 has weak low bits (e.g. for ids of digits), so they are mixed with a multiplicative (fibonacci) step
+static inline int home_slot(unsigned long hash, int capacity)
+{
+	return (int) ((((uint64_t) hash * 0x9E3779B97F4A7C15ULL) >> 32) & (capacity - 1));
+}
+
+// how far from its home slot, an element at given slot is
+static inline int probe_distance(struct slot * slot, int index, int capacity)
+{
+	return (index - home_slot(slot->hash, capacity)) & (capacity - 1);
+}
+
+static struct slot * table_create(int capacity)
+{
+	// calloc marks all slots as empty, and large zeroed allocations are mapped lazily
+	struct slot * table = calloc(capacity, sizeof(struct slot));
+	if (table == NULL)
+		fprintf(stderr, "Error : table_create -> calloc\n");
+	assert(table != NULL);
+	return table;
+}
+
 HT hash_create(int capacity, int type)
 {
 	//malloc HT structure
@@ -33,20 +72,26 @@ HT hash_create(int capacity, int type)
 		fprintf(stderr, "Error : hash_create -> malloc\n");
 	assert(hash != NULL);
 
-	// malloc hash table of given size, of pointers to lists
-  	hash->table = malloc(capacity * sizeof(List));
-	if (hash->table == NULL)
-		fprintf(stderr, "Error : hash_create -> malloc\n");
-	assert(hash->table != NULL);
-
-	// initialize all list pointers of hashtable to NULL
-  	for (int i = 0; i < capacity; ++i)
-    	hash->table[i] = NULL;
+	// round capacity up to a power of 2, so that a slot is found by masking instead of a modulo
+	int table_capacity = MIN_CAPACITY;
+	while (table_capacity < capacity)
+		table_capacity *= 2;
 
-    hash->capacity = capacity;
+	hash->table = table_create(table_capacity);
+	hash->capacity = table_capacity;
   	hash->size = 0;
   	hash->type = type;
 
+  	hash->entries_capacity = table_capacity;
+  	hash->entries = malloc(hash->entries_capacity * sizeof(void *));
+	if (hash->entries == NULL)
+		fprintf(stderr, "Error : hash_create -> malloc\n");
+	assert(hash->entries != NULL);
+
+  	hash->old_table = NULL;
+  	hash->old_capacity = 0;
+  	hash->migrated = 0;
+
 	return hash;
 }
 
@@ -68,109 +113,192 @@ int hash_capacity(HT hash)
 	return hash->capacity;
 }
 
+size_t hash_memory(HT hash)
+{
+	if (hash == NULL)
+		fprintf(stderr, "Error : hash_memory -> HT hash is NULL\n");
+	assert(hash != NULL);
+
+	return sizeof(struct hash_table) + (hash->capacity + hash->old_capacity) * sizeof(struct slot) + hash->entries_capacity * sizeof(void *);
+}
+
 void hash_destroy(HT hash)
 {
 	if (hash == NULL)
 		fprintf(stderr, "Error : hash_destroy -> HT hash is NULL\n");
 	assert(hash != NULL);
 
-	for (int i = 0; i < hash->capacity; ++i)
+	//delete all elements of hash table (citizen records belong to the arena of the citizens, which is released as a whole)
+	for (int i = 0; hash->type != 0 && i < hash->size; ++i)
 	{
-		if (hash->table[i] != NULL)
-			list_destroy(hash->table[i]);		//delete all linked lists of hash table
+		switch (hash->type)
+		{
+			case 1 : virus_info_destroy((VirusInfo) hash->entries[i]); break;
+			case 2 : country_info_destroy((CountryInfo) hash->entries[i]); break;
+		}
 	}
 
-	// at last, delete the hash and hash_table data structure
+	// at last, delete the tables and hash_table data structure
+	free(hash->entries);
+	free(hash->old_table);
 	free(hash->table);
 	free(hash);
 }
 
+// searches given table for given key of given hash (if key is NULL, the hash is an integer key, and is compared alone)
+static void * table_search(struct slot * table, int capacity, void * key, unsigned long hash_value)
+{
+	int index = home_slot(hash_value, capacity);
+	for (int distance = 0; ; distance++, index = (index + 1) & (capacity - 1))
+	{
+		struct slot * slot = &table[index];
+		// elements are kept ordered by distance from home (robin hood), so the key would have been found by now
+		if (slot->key == NULL || probe_distance(slot, index, capacity) < distance)
+			return NULL;
+		if (slot->hash == hash_value && (key == NULL || !strcmp(slot->key, (char *) key)))
+			return slot->value;
+	}
+}
+
 void * hash_search(HT hash, void * key)
 {
 	if (hash == NULL)
 		fprintf(stderr, "Error : hash_search -> HT hash is NULL\n");
 	assert(hash != NULL);
 
-	int index = (int) (hash_function((unsigned char *) key) % hash->capacity);
+	if (hash->type == 0)		// citizens are keyed by the integer value of their id
+		return hash_search_citizen(hash, citizen_key((char *) key));
+
+	unsigned long hash_value = hash_function((unsigned char *) key);
+
+	void * value = table_search(hash->table, hash->capacity, key, hash_value);
 
-	if (hash->table[index] == NULL) 		// if no previous entry has hashed into that bucket
-		return NULL;  						// then obviously given key does not exist into the hash-table
-	else
-		return list_search(hash->table[index], key);
+	// while rehashing, the entry may still be only in the previous table (which is never modified, so it can be searched as is)
+	if (value == NULL && hash->old_table != NULL)
+		value = table_search(hash->old_table, hash->old_capacity, key, hash_value);
+
+	return value;
 }
 
-// if load factor becomes too large, rehash the hash table by doubling its capacity
-static void rehash(HT hash)
+void * hash_search_citizen(HT hash, uint64_t key)
 {
-	// keep previous capacity, array of lists
-	int prev_capacity = hash->capacity;
-	List * prev_table = hash->table;
+	if (hash == NULL)
+		fprintf(stderr, "Error : hash_search_citizen -> HT hash is NULL\n");
+	assert(hash != NULL);
 
-	hash->capacity = hash->capacity*2; 		// double hash table's capacity
+	if (key == NO_CITIZEN_KEY)		// id is not a string of digits, so no citizen has it
+		return NULL;
+
+	void * value = table_search(hash->table, hash->capacity, NULL, key);
+	if (value == NULL && hash->old_table != NULL)
+		value = table_search(hash->old_table, hash->old_capacity, NULL, key);
+
+	return value;
+}
+
+void hash_prefetch_citizen(HT hash, uint64_t key)
+{
+	if (hash == NULL)
+		fprintf(stderr, "Error : hash_prefetch_citizen -> HT hash is NULL\n");
+	assert(hash != NULL);
+
+	__builtin_prefetch(&hash->table[home_slot(key, hash->capacity)]);
+}
+
+static void * get_key(HT hash, void * value)
+{
+	switch (hash->type)
+	{
+		case 0 : return get_citizen_id((CitizenInfo) value);
+		case 1 : return get_virus_name((VirusInfo) value);
+		case 2 : return get_country_name((CountryInfo) value);
+	}
+	return NULL;
+}
 
-	hash->table = malloc(hash->capacity * sizeof(List));  // malloc new hash table with double capacity
-	if (hash->table == NULL)
-		fprintf(stderr, "Error : rehash -> malloc\n");
-	assert(hash->table != NULL);
-
-	// re-initialize all list pointers of hashtable to NULL
-  	for (int i = 0; i < hash->capacity; ++i)
-    	hash->table[i] = NULL;
-
-    hash->size = 0;
-
-    // now re-insert all previous elements of the hash table to the bigger hash-table
-    for (int i = 0; i < prev_capacity; i++)
-    {
-    	if (prev_table[i] != NULL)
-    	{
-    		for (ListNode node = list_first(prev_table[i]); node != NULL; node = list_next(prev_table[i], node))
-    			hash_insert(hash, list_value(prev_table[i], node));
-    	}
-    }
-
-    // finally, delete the previous hash-table
-    // Also delete the list nodes of previous hash-tables, but not their data, since the list nodes of new hash table point to that data
-    for (int i = 0; i < prev_capacity; ++i)
+// inserts given slot into the (current) hash table, without checking the load factor
+// robin hood : an element that is further from its home slot takes the place of one that is closer to its own
+static void slot_insert(HT hash, struct slot new_slot)
+{
+	int index = home_slot(new_slot.hash, hash->capacity);
+	for (int distance = 0; ; distance++, index = (index + 1) & (hash->capacity - 1))
 	{
-		if (prev_table[i] != NULL)		// for each not null list of previous hash-table
+		struct slot * slot = &hash->table[index];
+		if (slot->key == NULL)
+		{
+			*slot = new_slot;
+			return;
+		}
+
+		int slot_distance = probe_distance(slot, index, hash->capacity);
+		if (slot_distance < distance)
 		{
-			ListNode node = list_dummy(prev_table[i]); 		// starting from fake-dummy node
-			
-			while (node != NULL) 	// for every node of list
-			{				
-				ListNode next = list_next(prev_table[i], node);		// save next node
-				free(node);   // free node of list
-				node = next;  // continue iteration of list
-			}
-			// at last free the struct of list
-			free(prev_table[i]);
+			struct slot displaced = *slot;
+			*slot = new_slot;
+			new_slot = displaced;
+			distance = slot_distance;
 		}
 	}
-	free(prev_table);		// delete the hash_table itself
+}
+
+// moves up to given number of slots of the previous table into the current one, in order
+static void migrate(HT hash, int num_of_slots)
+{
+	for ( ; num_of_slots > 0 && hash->migrated < hash->old_capacity; num_of_slots--, hash->migrated++)
+	{
+		if (hash->old_table[hash->migrated].key != NULL)
+			slot_insert(hash, hash->old_table[hash->migrated]);
+	}
+
+	if (hash->migrated == hash->old_capacity)		// all elements have been moved, delete the previous hash-table
+	{
+		free(hash->old_table);
+		hash->old_table = NULL;
+		hash->old_capacity = 0;
+		hash->migrated = 0;
+	}
+}
+
+// if load factor becomes too large, start rehashing the hash table into a new one of double capacity
+// Elements are not re-inserted all at once : every following insert moves a few slots of the previous table,
+// so that no single insert pays for the whole table
+static void rehash(HT hash)
+{
+	if (hash->old_table != NULL)		// previous rehash is not over yet (should not happen, since slots move faster than the table fills)
+		migrate(hash, hash->old_capacity);
+
+	hash->old_table = hash->table;
+	hash->old_capacity = hash->capacity;
+	hash->migrated = 0;
+
+	hash->capacity = hash->capacity*2; 		// double hash table's capacity
+	hash->table = table_create(hash->capacity);
 }
 
 void hash_insert(HT hash, void * value)
 {
 	if (hash == NULL)
-		fprintf(stderr, "Error : hash_search -> HT hash is NULL\n");
+		fprintf(stderr, "Error : hash_insert -> HT hash is NULL\n");
 	assert(hash != NULL);
-	void * key;
-	
-	switch (hash->type)
-	{
-		case 0 : key = get_citizen_id((CitizenInfo) value); break;
-		case 1 : key = get_virus_name((VirusInfo) value); break;
-		case 2 : key = get_country_name((CountryInfo) value); break;
-	}
 
-	int index = (int) (hash_function((unsigned char *) key) % hash->capacity);
+	if (hash->old_table != NULL)		// a rehash is in progress, move a few more slots
+		migrate(hash, MIGRATE_SLOTS);
+
+	struct slot new_slot;
+	new_slot.key = get_key(hash, value);
+	new_slot.hash = (hash->type == 0) ? get_citizen_key((CitizenInfo) value) : hash_function((unsigned char *) new_slot.key);
+	new_slot.value = value;
+	slot_insert(hash, new_slot);
 
-	if (hash->table[index] == NULL) 		// if no previous entry has hashed into that bucket
-		hash->table[index] = list_create(hash->type);		// create new bucket-list at index
-	
-	list_insert_end(hash->table[index], value);			// insert value at end of list
-	hash->size++;
+	if (hash->size == hash->entries_capacity)
+	{
+		hash->entries_capacity *= 2;
+		hash->entries = realloc(hash->entries, hash->entries_capacity * sizeof(void *));
+		if (hash->entries == NULL)
+			fprintf(stderr, "Error : hash_insert -> realloc\n");
+		assert(hash->entries != NULL);
+	}
+	hash->entries[hash->size++] = value;
 
 	// If after insertion, load factor becomes too large, rehash the hash table
 	float load_factor = (float) hash->size / hash->capacity;
@@ -184,66 +312,49 @@ void hash_print(HT hash)
 		fprintf(stderr, "Error : hash_print -> HT hash is NULL\n");
 	assert(hash != NULL);
 
-	for (int i = 0; i < hash->capacity; ++i)
+	for (int i = 0; i < hash->size; ++i)
 	{
-		if (hash->table[i] != NULL)
+		switch (hash->type)
 		{
-			printf("%d:chain \n\n", i);
-			list_print(hash->table[i]);
+			case 0 : citizen_info_print((CitizenInfo) hash->entries[i]); break;
+			case 1 : virus_info_print((VirusInfo) hash->entries[i]); break;
+			case 2 : country_info_print((CountryInfo) hash->entries[i]); break;
 		}
 	}
-
 }
 
-void * hash_iterate_next(HT hash)
+void hash_cursor_begin(HT hash, struct hash_cursor * cursor)
 {
 	if (hash == NULL)
-		fprintf(stderr, "Error : hash_iterate_next -> HT hash is NULL\n");
+		fprintf(stderr, "Error : hash_cursor_begin -> HT hash is NULL\n");
 	assert(hash != NULL);
 
-	static ListNode cur_node = NULL;
-	static int index = 0;
-
-	if (cur_node == NULL)				// if the iteration of hash-table begins now
-	{
-		for (int i = 0; i < hash->capacity; ++i)
-		{
-			if (hash->table[i] != NULL)
-			{
-				cur_node = list_first(hash->table[i]);
-				index = i;
-				return (list_value(hash->table[i], cur_node));
-			}
-		}
+	cursor->hash = hash;
+	cursor->index = 0;
+}
 
-		return NULL;		// no elements found
-	}
-	else
-	{	// iteration has already begun
-		if (list_next(hash->table[index], cur_node) != NULL)	// if current list's next element is not NULL
-		{
-			cur_node = list_next(hash->table[index], cur_node);		// save next node
-			return (list_value(hash->table[index], cur_node));		// return next element
-		}
-		else
-		{	// we have reached end of current list
-			for (int i = index+1; i < hash->capacity; ++i)  // search for next non-empty list of hash-table
-			{
-				if (hash->table[i] != NULL)					// if you find such a list
-				{
-					cur_node = list_first(hash->table[i]);	// save first node , to start traversing the list
-					index = i;
-					return (list_value(hash->table[i], cur_node));	// and obviously return the element
-				}
-			}
-
-			// reached end of iteration over all entries of hash table
-			cur_node = NULL;		// re-initialize cur_node, index to NULL, 0 for any iteration that may follow
-			index = 0;	
-			return NULL;			// no remaining elements found
-		}
-	}
+void * hash_cursor_next(struct hash_cursor * cursor)
+{
+	if (cursor->hash == NULL)
+		fprintf(stderr, "Error : hash_cursor_next -> iteration has ended\n");
+	assert(cursor->hash != NULL);
 
+	// elements are iterated over the dense array of entries, in insertion order (elements inserted meanwhile are reached as well)
+	if (cursor->index < cursor->hash->size)
+		return cursor->hash->entries[cursor->index++];
 	return NULL;
+}
+
+void hash_cursor_end(struct hash_cursor * cursor)
+{
+	cursor->hash = NULL;		// the cursor holds nothing else, so that ending an iteration early is as cheap as running it out
+}
+
+void * hash_entry(HT hash, int index)
+{
+	if (hash == NULL)
+		fprintf(stderr, "Error : hash_entry -> HT hash is NULL\n");
+	assert(hash != NULL && index >= 0 && index < hash->size);
 
+	return hash->entries[index];
 }
@@ -1,9 +1,17 @@
 /*file : hash.h */
 #pragma once
+#include <stdint.h>
 #include "list.h"
 
 typedef struct hash_table * HT;
 
+/* position of an iteration over a hash table. Every iteration has a cursor of its own (on the stack of its caller),
+   so that iterations can nest, stop early, or run from several threads at once */
+struct hash_cursor {
+	HT hash;
+	int index;
+};
+
 // a simple hash function for strings
 unsigned long hash_function(unsigned char *str);
 // creates hash table structure of given capacity
@@ -12,13 +20,25 @@ HT hash_create(int capacity, int type);
 int hash_size(HT hash);
 // returns number of buckets currently in hash table
 int hash_capacity(HT hash);
+// returns number of bytes taken by the hash table itself (not by its elements)
+size_t hash_memory(HT hash);
 // deletes the hash table structure
 void hash_destroy(HT hash);
 // inserts entry with given value
 void hash_insert(HT hash, void * value);
 // searches for entry with given key
 void * hash_search(HT hash, void * key);
+// searches the citizens hash table for the citizen with given integer key (see citizen_key)
+void * hash_search_citizen(HT hash, uint64_t key);
+// prefetches the slot a later search of the citizen with given integer key starts from
+void hash_prefetch_citizen(HT hash, uint64_t key);
 //print hash table (debugging)
 void hash_print(HT hash);
-// function that is used to iterate through hash table
-void * hash_iterate_next(HT hash);
\ No newline at end of file
+// starts an iteration over the elements of hash table with given cursor, in insertion order
+void hash_cursor_begin(HT hash, struct hash_cursor * cursor);
+// returns the next element of the iteration of given cursor, NULL when there are no more elements
+void * hash_cursor_next(struct hash_cursor * cursor);
+// ends the iteration of given cursor (an iteration may end before reaching its last element)
+void hash_cursor_end(struct hash_cursor * cursor);
+// returns the element inserted index-th (0 <= index < hash_size), e.g. the virus or country of a dense id
+void * hash_entry(HT hash, int index);
\ No newline at end of file
@@ -58,7 +58,7 @@ void list_destroy(List list)
 			// delete/free each of the node's components 
 			switch (list->type)
 			{
-				case 0 : citizen_info_destroy((CitizenInfo) node->value); break;
+				case 0 : break;		// citizen records belong to the arena of the citizens
 				case 1 : virus_info_destroy((VirusInfo) node->value); break;
 				case 2 : country_info_destroy((CountryInfo) node->value); break;
 			}
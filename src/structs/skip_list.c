@@ -4,24 +4,52 @@
 #include <string.h>
 #include "skip_list.h"
 #include "items.h"
+#include "arena.h"
 #include <assert.h>
 
-/* data structure for skip list node */
+#define NODE_SLAB_SIZE (256 * 1024)		// nodes of a skip list are allocated from slabs of this size
+
+/* data structure for skip list node : a single block, sized by the level of the node */
 struct skip_list_node {
-	int level;       				// how high in terms of levels the skip list node is 
-	SkipListNode * next_array;		// each node has an array of as many pointers to nodes as its level, which size is decided dynamically at creation
+	uint64_t key;					// integer key of the citizen id (kept inline, so that searching never touches the citizen record)
 	CitizenInfo info;				// each node has a pointer to a citizen record, and the citizen id serves as a key;
-	char * date;					// date of vaccination (NULL if person is not vaccinated)
+	Date date;						// day number of vaccination (NO_DATE if person is not vaccinated)
+	int level;       				// how high in terms of levels the skip list node is 
+	SkipListNode next_array[];		// each node has an array of as many pointers to nodes as its level, at the end of the node itself
 };
 
 /* data structure of skip list */
 struct skip_list {
 	SkipListNode header_dummy_node;		// this serves as a pointer to the first header/dummy node of skip_list (which has an array of head pointers for all pararell lists)
 	int cur_level;						// the current height of the skip-list (the level of the top skip-list)
+	long size;							// number of nodes of the skip list (besides the header node)
 	int max_level;						// this is the maximum level-height for the top skip-list
 	float prob;							// this is the probability that a new level is created for a skip-list node
+	unsigned int seed;					// state of the random generator of the skip list, so that different skip lists can be built in parallel
+	Arena pool;							// memory of all the nodes of the skip list
+	SkipListNode * free_nodes;			// deleted nodes, for reuse, one free list per level (linked through next_array[0])
 };
 
+/* returns a node of given level from the pool of the skip list (a deleted node of the same level if there is one) */
+static SkipListNode node_create(SkipList skip_list, CitizenInfo info, Date date, int level)
+{
+	SkipListNode node = skip_list->free_nodes[level];
+	if (node != NULL)
+		skip_list->free_nodes[level] = node->next_array[0];
+	else
+		node = arena_alloc(skip_list->pool, sizeof(struct skip_list_node) + (level+1) * sizeof(SkipListNode));
+
+	node->key = (info == NULL) ? NO_CITIZEN_KEY : get_citizen_key(info);
+	node->info = info;
+	node->date = date;
+	node->level = level;
+
+	for (int i = 0; i <= level; i++)
+		node->next_array[i] = NULL;
+
+	return node;
+}
+
 
 SkipList skip_list_create(int max_level, float prob)
 {
@@ -32,27 +60,23 @@ SkipList skip_list_create(int max_level, float prob)
 
 	skip_list->max_level = max_level;		// assign the max level
 	skip_list->prob = prob;
+	skip_list->seed = (unsigned int) rand();
 	skip_list->cur_level = 0;				// current level is 0 upon creation (we are at L0)
+	skip_list->size = 0;
 
-	skip_list->header_dummy_node = malloc(sizeof(struct skip_list_node));		// allocate memory for first node, which is the head-dummy node
-	if (skip_list->header_dummy_node == NULL)
-		fprintf(stderr, "Error : skip_list_create -> malloc\n");
-	assert(skip_list->header_dummy_node != NULL);
-
-	skip_list->header_dummy_node->next_array = malloc((max_level+1)*sizeof(SkipListNode));		// allocate memory for the array of head pointers of head node
+	skip_list->pool = arena_create(NODE_SLAB_SIZE);
+	skip_list->free_nodes = calloc(max_level+1, sizeof(SkipListNode));
+	if (skip_list->free_nodes == NULL)
+		fprintf(stderr, "Error : skip_list_create -> calloc\n");
+	assert(skip_list->free_nodes != NULL);
 
-	for (int i = 0; i <= max_level; ++i)		// initialize all header pointers to NULL
-	{
-		skip_list->header_dummy_node->next_array[i] = NULL;
-	}
-
-	skip_list->header_dummy_node->info = NULL;		// header-dummy node contains no real data-info
-	skip_list->header_dummy_node->date = NULL;
+	// first node is the head-dummy node, with an array of head pointers (all NULL) for all levels. It contains no real data-info
+	skip_list->header_dummy_node = node_create(skip_list, NULL, NO_DATE, max_level);
 
 	return skip_list;
 }
 
-bool skip_list_search(SkipList skip_list, char * value, char ** date)
+bool skip_list_search(SkipList skip_list, uint64_t key, Date * date)
 {
 	if (skip_list == NULL)
 		fprintf(stderr, "Error : skip_list_search -> skip list is NULL\n");
@@ -67,11 +91,7 @@ bool skip_list_search(SkipList skip_list, char * value, char ** date)
 		next_node = cur_node->next_array[level];		// we traverse the nodes of skip list of current level
 		while (next_node != NULL)
 		{
-			int check; 				// check for equality of id's
-			if (strlen((char *) value) == strlen((char *) get_citizen_id(next_node->info)))
-				check = strcmp((char *) value, (char *) get_citizen_id(next_node->info));
-			else
-				check = (strlen((char *) value) > strlen((char *) get_citizen_id(next_node->info))) ? 1 : -1 ;
+			int check = (key > next_node->key) - (key < next_node->key); 		// check for equality of id's
 
 			if (!check)
 			{
@@ -93,21 +113,51 @@ bool skip_list_search(SkipList skip_list, char * value, char ** date)
 	return false;
 }
 
+void skip_list_search_sorted(SkipList skip_list, const uint64_t * keys, long num_of_keys, bool * found, Date * dates)
+{
+	if (skip_list == NULL)
+		fprintf(stderr, "Error : skip_list_search_sorted -> skip list is NULL\n");
+	assert(skip_list != NULL);
+
+	// path[level] is the last node of each level that is before the previous key, so it is also before the current (larger or equal) key
+	SkipListNode path[skip_list->max_level + 1];
+	for (int level = 0; level <= skip_list->max_level; level++)
+		path[level] = skip_list->header_dummy_node;
+
+	for (long i = 0; i < num_of_keys; i++)
+	{
+		SkipListNode cur_node = skip_list->header_dummy_node;
+		for (int level = skip_list->cur_level; level >= 0; level--)
+		{
+			// start each level from the node further ahead : the one the level above stopped at, or the one the previous key stopped at
+			if (cur_node == skip_list->header_dummy_node || (path[level] != skip_list->header_dummy_node && path[level]->key > cur_node->key))
+				cur_node = path[level];
+			while (cur_node->next_array[level] != NULL && cur_node->next_array[level]->key < keys[i])
+				cur_node = cur_node->next_array[level];
+			path[level] = cur_node;
+		}
+
+		SkipListNode next_node = cur_node->next_array[0];
+		found[i] = (next_node != NULL && next_node->key == keys[i]);
+		dates[i] = found[i] ? next_node->date : NO_DATE;
+	}
+}
+
 int random_level(SkipList skip_list)
 {
 	int level = 0;
-	float p = (float) rand() / (float) ((unsigned)RAND_MAX + 1);		// generate random probability in [0,1)
+	float p = (float) rand_r(&skip_list->seed) / (float) ((unsigned)RAND_MAX + 1);		// generate random probability in [0,1)
 	// keep adding levels, as long as we dont exceed max level and generated probability is smaller than parameter probability
 	while (p < skip_list->prob && level < skip_list->max_level)			
 	{
 		level++;
-		p = (float) rand() / (float) ((unsigned)RAND_MAX + 1);
+		p = (float) rand_r(&skip_list->seed) / (float) ((unsigned)RAND_MAX + 1);
 	}
 
 	return level;
 }
 
-void skip_list_insert(SkipList skip_list, void * data, char * date)
+void skip_list_insert(SkipList skip_list, void * data, Date date)
 {
 	if (skip_list == NULL)
 		fprintf(stderr, "Error : skip_list_insert -> skip list is NULL\n");
@@ -120,6 +170,7 @@ void skip_list_insert(SkipList skip_list, void * data, char * date)
 	SkipListNode cur_node = skip_list->header_dummy_node;		// start searching from the head node of the top level skip list
 	SkipListNode next_node = NULL, temp_node = NULL;
 	SkipListNode node_path[skip_list->max_level+1];				// the path will consist of at most as many nodes as the max height of the tallest skip-list
+	uint64_t key = get_citizen_key((CitizenInfo) data);
 
 	for (int i = 0; i <= level; ++i)
 		node_path[i] = NULL;
@@ -129,11 +180,7 @@ void skip_list_insert(SkipList skip_list, void * data, char * date)
 		next_node = cur_node->next_array[level];
 		while (next_node != NULL)
 		{
-			int check; 				// check for equality of id's
-			if (strlen((char *) get_citizen_id((CitizenInfo) data)) == strlen((char *) get_citizen_id(next_node->info)))
-				check = strcmp((char *) get_citizen_id((CitizenInfo) data), (char *) get_citizen_id(next_node->info));
-			else
-				check = (strlen((char *) get_citizen_id((CitizenInfo) data)) > strlen((char *) get_citizen_id(next_node->info))) ? 1 : -1 ;
+			int check = (key > next_node->key) - (key < next_node->key); 		// check for equality of id's
 		
 			if (!check)
 			{
@@ -161,23 +208,8 @@ void skip_list_insert(SkipList skip_list, void * data, char * date)
 	}
 
 	// now we create a new node at the base level L0
-	// and initialize its components
-	SkipListNode new_node = malloc(sizeof(struct skip_list_node));
-	if (date != NULL)
-	{
-		new_node->date = (char *) malloc(strlen(date)+1);
-		memcpy(new_node->date, date, strlen(date)+1);
-	}
-	else
-		new_node->date = NULL;
-	
-	new_node->info = (CitizenInfo) data;
-	new_node->level = random_level(skip_list);
-
-	new_node->next_array = malloc((new_node->level+1) * sizeof(SkipListNode));		// generate next array, as big as the level of the new node
-	if (new_node->next_array == NULL)
-		fprintf(stderr, "Error : skip_list_insert -> malloc\n");
-	assert(skip_list != NULL);
+	// with a next array as big as its level
+	SkipListNode new_node = node_create(skip_list, (CitizenInfo) data, date, random_level(skip_list));
 
 	// if level of new node is higher than current level, complete the path nodes, with the header node
 	if (new_node->level > skip_list->cur_level)
@@ -196,11 +228,103 @@ void skip_list_insert(SkipList skip_list, void * data, char * date)
 		node_path[i]->next_array[i] = new_node;
 		new_node->next_array[i] = temp_node;
 	}
+	skip_list->size++;
+
+}
+
+
+bool skip_list_is_empty(SkipList skip_list)
+{
+	if (skip_list == NULL)
+		fprintf(stderr, "Error : skip_list_is_empty -> skip list is NULL\n");
+	assert(skip_list != NULL);
 
+	return skip_list->header_dummy_node->next_array[0] == NULL;
 }
 
+long skip_list_size(SkipList skip_list)
+{
+	if (skip_list == NULL)
+		fprintf(stderr, "Error : skip_list_size -> skip list is NULL\n");
+	assert(skip_list != NULL);
+
+	return skip_list->size;
+}
 
-void skip_list_delete(SkipList skip_list, char * value)
+void skip_list_build(SkipList skip_list, void ** data, Date * dates, long size)
+{
+	if (skip_list == NULL)
+		fprintf(stderr, "Error : skip_list_build -> skip list is NULL\n");
+	assert(skip_list != NULL);
+
+	if (skip_list->header_dummy_node->next_array[0] != NULL)
+		fprintf(stderr, "Error : skip_list_build -> skip list is not empty\n");
+	assert(skip_list->header_dummy_node->next_array[0] == NULL);
+
+	// since data are given sorted, every new node is the last one on all of its levels
+	// so we only need to remember the last node of each level, and link the new node after it
+	SkipListNode last[skip_list->max_level+1];
+	for (int i = 0; i <= skip_list->max_level; ++i)
+		last[i] = skip_list->header_dummy_node;
+
+	for (long j = 0; j < size; j++)
+	{
+		SkipListNode new_node = node_create(skip_list, (CitizenInfo) data[j], (dates != NULL) ? dates[j] : NO_DATE, random_level(skip_list));
+
+		for (int i = 0; i <= new_node->level; i++)
+		{
+			last[i]->next_array[i] = new_node;
+			last[i] = new_node;
+		}
+
+		if (new_node->level > skip_list->cur_level)
+			skip_list->cur_level = new_node->level;
+	}
+	skip_list->size = size;
+}
+
+void skip_list_traverse(SkipList skip_list, void (*visit)(void * data, Date date, void * arg), void * arg)
+{
+	if (skip_list == NULL)
+		fprintf(stderr, "Error : skip_list_traverse -> skip list is NULL\n");
+	assert(skip_list != NULL);
+
+	// nodes of level zero list are visited in ascending order of citizen id
+	for (SkipListNode node = skip_list->header_dummy_node->next_array[0]; node != NULL; node = node->next_array[0])
+		visit(node->info, node->date, arg);
+}
+
+void skip_list_cursor_begin(SkipList skip_list, int level, struct skip_list_cursor * cursor)
+{
+	if (skip_list == NULL)
+		fprintf(stderr, "Error : skip_list_cursor_begin -> skip list is NULL\n");
+	assert(skip_list != NULL && level >= 0 && level <= skip_list->max_level);
+
+	// a level above the current height of the skip list has no nodes, its head pointer in the header node is NULL
+	cursor->node = skip_list->header_dummy_node;
+	cursor->level = level;
+}
+
+void * skip_list_cursor_next(struct skip_list_cursor * cursor, Date * date)
+{
+	if (cursor->node == NULL)
+		return NULL;
+
+	cursor->node = cursor->node->next_array[cursor->level];
+	if (cursor->node == NULL)			// reached the end of the level
+		return NULL;
+
+	if (date != NULL)
+		*date = cursor->node->date;
+	return cursor->node->info;
+}
+
+void skip_list_cursor_end(struct skip_list_cursor * cursor)
+{
+	cursor->node = NULL;
+}
+
+void skip_list_delete(SkipList skip_list, uint64_t key)
 {
 	if (skip_list == NULL)
 		fprintf(stderr, "Error : skip_list_delete -> skip list is NULL\n");
@@ -223,11 +347,7 @@ void skip_list_delete(SkipList skip_list, char * value)
 		next_node = cur_node->next_array[level];
 		while (next_node != NULL)
 		{
-			int check; 				// check for equality of id's
-			if (strlen((char *) value) == strlen((char *) get_citizen_id(next_node->info)))
-				check = strcmp((char *) value, (char *) get_citizen_id(next_node->info));
-			else
-				check = (strlen((char *) value) > strlen((char *) get_citizen_id(next_node->info))) ? 1 : -1 ;
+			int check = (key > next_node->key) - (key < next_node->key); 		// check for equality of id's
 
 			if (!check)   // next node has the target value as primary key, hence we currently are at the predecessor
 			{
@@ -267,11 +387,10 @@ void skip_list_delete(SkipList skip_list, char * value)
 			skip_list->cur_level--;
 	}
 
-	// free all alloced components of target node, and the target node itself
-	free(target_node->next_array);
-	if (target_node->date != NULL)
-		free(target_node->date);
-	free(target_node);
+	// target node goes back to the pool, to be reused by a node of the same level
+	target_node->next_array[0] = skip_list->free_nodes[target_node->level];
+	skip_list->free_nodes[target_node->level] = target_node;
+	skip_list->size--;
 
 }
 
@@ -282,21 +401,9 @@ void skip_list_destroy(SkipList skip_list)
 		fprintf(stderr, "Error : skip_list_destroy -> skip list is NULL\n");
 	assert(skip_list != NULL);
 
-	// we will just traverse and delete the nodes from the L0 base list, since all the nodes at level 0 are connected
-	SkipListNode node = skip_list->header_dummy_node;		// begin traversal from header dummy node
-	SkipListNode temp_node;
-
-	// delete dummy node and all nodes of list (including all of their components)
-	while (node != NULL)
-	{
-		temp_node = node;
-		node = node->next_array[0];		// traversal of level zero list
-		free(temp_node->next_array);
-		if (temp_node->date != NULL)
-			free(temp_node->date);
-		free(temp_node);
-	}
-
+	// all nodes (and the dummy node) are in the pool, which is released slab by slab, without traversing the list
+	arena_destroy(skip_list->pool);
+	free(skip_list->free_nodes);
 	free(skip_list); 		// delete the skip_list structure
 }
 
@@ -349,78 +456,24 @@ void skip_list_print_data(SkipList skip_list)
 	printf("\n\n");
 }
 
-int skip_list_GroupByCountry(SkipList skip_list, char * country, char * date1, char * date2)
+void skip_list_GroupByCountryAge(SkipList skip_list, Date from, Date to, int * counts, int num_of_countries)
 {
 	if (skip_list == NULL)
-		fprintf(stderr, "Error : skip_list_GroupByCountry -> skip list is NULL\n");
-	assert(skip_list != NULL);
-
-	if (country == NULL)
-		fprintf(stderr, "Error : skip_list_GroupByCountry -> country is NULL\n");
+		fprintf(stderr, "Error : skip_list_GroupByCountryAge -> skip list is NULL\n");
 	assert(skip_list != NULL);
 
-	int num_of_people = 0;
-
-	// we will just traverse the nodes from the L0 base list, since all the nodes at level 0 are connected
-	SkipListNode node = skip_list->header_dummy_node;		// begin traversal from header dummy node
-
-	// traverse all the way to the end
-	while (node != NULL)
+	// a single traversal of the level zero list, for all countries at once : countries are compared by their dense ids, never by name
+	for (SkipListNode node = skip_list->header_dummy_node->next_array[0]; node != NULL; node = node->next_array[0])
 	{
-		if (node->info != NULL)
+		// if no dates are given, or if we are traversing the non-vaccinated persons skip_list or node's date is in given interval
+		if (from == NO_DATE || node->date == NO_DATE || (node->date >= from && node->date <= to))
 		{
-			if (!strcmp(country, get_citizen_country(node->info)))
-			{
-				// if no dates are given, or if we are traversing the non-vaccinated persons skip_list or node's date is in given interval
-				if (date1 == NULL || node->date == NULL || (date_cmp(node->date, date1) >= 0 && date_cmp(node->date, date2) <= 0))
-					num_of_people++;
-			}
-		}
-
-		node = node->next_array[0];		// traversal of level zero list
-	}
-
-	return num_of_people;
-}
-
-void skip_list_GroupByAge(SkipList skip_list, char * country, char * date1, char * date2, int * group1, int * group2, int * group3, int * group4)
-{
-	if (skip_list == NULL)
-		fprintf(stderr, "Error : skip_list_GroupByAge -> skip list is NULL\n");
-	assert(skip_list != NULL);
+			int country_id = get_country_id(get_citizen_country_info(node->info));
+			if (country_id >= num_of_countries)
+				fprintf(stderr, "Error : skip_list_GroupByCountryAge -> country id out of range\n");
+			assert(country_id < num_of_countries);
 
-	if (country == NULL)
-		fprintf(stderr, "Error : skip_list_GroupByAge -> country is NULL\n");
-	assert(skip_list != NULL);
-
-	*group1 = 0; *group2 = 0; *group3 = 0; *group4 = 0;
-
-	// we will just traverse the nodes from the L0 base list, since all the nodes at level 0 are connected
-	SkipListNode node = skip_list->header_dummy_node;		// begin traversal from header dummy node
-
-	// traverse all the way to the end
-	while (node != NULL)
-	{
-		if (node->info != NULL)
-		{
-			if (!strcmp(country, get_citizen_country(node->info)))
-			{
-				// if no dates are given, or if we are traversing the non-vaccinated persons skip_list or node's date is in given interval
-				if (date1 == NULL || node->date == NULL || (date_cmp(node->date, date1) >= 0 && date_cmp(node->date, date2) <= 0))
-				{
-					int age = get_citizen_age(node->info);
-					if (age < 20)
-						(*group1) += 1;
-					else if (age < 40)
-						(*group2) += 1;
-					else if (age < 60)
-						(*group3) += 1;
-					else 
-						(*group4) += 1;
-				}
-			}
+			counts[country_id * AGE_GROUPS + age_group(get_citizen_age(node->info))]++;
 		}
-
-		node = node->next_array[0];		// traversal of level zero list
 	}
-}
\ No newline at end of file
+}
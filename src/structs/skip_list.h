@@ -1,28 +1,52 @@
 /*file : skip_list.h*/
 #pragma once
 #include <stdbool.h>
+#include <stdint.h>
+#include "date.h"
 
 typedef struct skip_list_node * SkipListNode;
 typedef struct skip_list * SkipList;
 
+/* position of an iteration over a level of a skip list. Every iteration has a cursor of its own (on the stack of its caller),
+   so that several of them can be in flight at once, from several threads as long as the skip list is not modified meanwhile */
+struct skip_list_cursor {
+	SkipListNode node;			// node returned last (the header node before the first one)
+	int level;
+};
+
 /* create a skip_list and return a pointer to the structure */
 SkipList skip_list_create(int max_level, float prob);
-/* search the skip list for a specific value */
-bool skip_list_search(SkipList skip_list, char * value, char ** date);
+/* search the skip list for the citizen with given integer key (see citizen_key) */
+bool skip_list_search(SkipList skip_list, uint64_t key, Date * date);
+/* searches the skip list for the citizens of given keys, sorted in ascending order, in a single pass : each search starts from where the previous one stopped, at every level.
+   found[i] (and dates[i]) tell if (and when) the citizen of keys[i] is in the skip list */
+void skip_list_search_sorted(SkipList skip_list, const uint64_t * keys, long num_of_keys, bool * found, Date * dates);
 /* insert given data into skip list*/
-void skip_list_insert(SkipList skip_list, void * data, char * date);
+void skip_list_insert(SkipList skip_list, void * data, Date date);
+/* returns true if the skip list has no nodes */
+bool skip_list_is_empty(SkipList skip_list);
+/* returns the number of nodes of the skip list */
+long skip_list_size(SkipList skip_list);
+/* builds the levels of an empty skip list in a single pass, from data (and dates) already sorted by citizen id */
+void skip_list_build(SkipList skip_list, void ** data, Date * dates, long size);
+/* visits the data and date of all nodes of the skip list, in ascending order of citizen id */
+void skip_list_traverse(SkipList skip_list, void (*visit)(void * data, Date date, void * arg), void * arg);
+/* starts an iteration with given cursor over the nodes of given level of the skip list (level 0 has all of them), in ascending order of citizen id */
+void skip_list_cursor_begin(SkipList skip_list, int level, struct skip_list_cursor * cursor);
+/* returns the data of the next node of the iteration of given cursor (and its date, if date is not NULL), NULL when there are no more nodes */
+void * skip_list_cursor_next(struct skip_list_cursor * cursor, Date * date);
+/* ends the iteration of given cursor (an iteration may end before reaching the last node) */
+void skip_list_cursor_end(struct skip_list_cursor * cursor);
 /* function that returns a random level for a new node , given a probability inside the skip-list structure */
 int random_level(SkipList skip_list);
-/* delete node with given value */
-void skip_list_delete(SkipList skip_list, char * value);
+/* delete node of the citizen with given integer key */
+void skip_list_delete(SkipList skip_list, uint64_t key);
 /* delete the skip_list structure and all of its components*/
 void skip_list_destroy(SkipList skip_list);
 /* prints all the levels of the skip_list (for debugging purposes) */
 void skip_list_print(SkipList skip_list);
 /* prints the data of all the nodes of the skip_list */
 void skip_list_print_data(SkipList skip_list);
-/* returns number of people for given country with entry in given date interval*/
-int skip_list_GroupByCountry(SkipList skip_list, char * country, char * date1, char * date2);
-/* returns number of people of skip list for country grouped by age in given date interval*/
-void skip_list_GroupByAge(SkipList skip_list, char * country, char * date1, char * date2, int * group1, int * group2, int * group3, int * group4);
-
+/* counts the people of the skip list with entry in given date interval (all of them if from is NO_DATE) in a single pass, for all countries : 
+   counts[country id * AGE_GROUPS + age group] is increased for each of them (counts has num_of_countries * AGE_GROUPS entries) */
+void skip_list_GroupByCountryAge(SkipList skip_list, Date from, Date to, int * counts, int num_of_countries);
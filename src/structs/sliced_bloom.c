@@ -0,0 +1,118 @@
+/*file : sliced_bloom.c*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "sliced_bloom.h"
+#include <assert.h>
+
+// data struct for bit-sliced bloom filter : row i holds bit i of the bloom filter of every set
+struct sliced_bloom {
+	uint8_t * rows;
+	unsigned long num_of_positions;
+	int num_of_hashes;
+	int row_size;				// bytes per row : 1, 2, 4 or 8 (so that a row is a single load), or a multiple of 8
+};
+
+SlicedBloom sliced_bloom_create(unsigned long num_of_positions, int num_of_hashes, int num_of_sets)
+{
+	SlicedBloom sliced = malloc(sizeof(*sliced));
+	if (sliced == NULL)
+		fprintf(stderr, "Error : sliced_bloom_create -> malloc\n");
+	assert(sliced != NULL);
+
+	int row_size = (num_of_sets + 7) / 8;
+	if (row_size <= 8)
+	{
+		int power = 1;
+		while (power < row_size)
+			power *= 2;
+		row_size = power;
+	}
+	else
+		row_size = (row_size + 7) / 8 * 8;
+
+	sliced->num_of_positions = (num_of_positions == 0) ? 1 : num_of_positions;
+	sliced->num_of_hashes = num_of_hashes;
+	sliced->row_size = row_size;
+	sliced->rows = calloc(sliced->num_of_positions, row_size);		// all bits are initially 0
+	if (sliced->rows == NULL)
+		fprintf(stderr, "Error : sliced_bloom_create -> calloc\n");
+	assert(sliced->rows != NULL);
+
+	return sliced;
+}
+
+/* row of the i-th hash function of a key : double hashing of the two halves of its hash (odd step), multiply and shift instead of a modulo */
+static uint8_t * row(SlicedBloom sliced, uint64_t hash, int i)
+{
+	uint32_t position = (uint32_t) hash + (uint32_t) i * ((uint32_t) (hash >> 32) | 1);
+	return sliced->rows + (((uint64_t) position * sliced->num_of_positions) >> 32) * sliced->row_size;
+}
+
+void sliced_bloom_insert(SlicedBloom sliced, int set, uint64_t hash)
+{
+	if (sliced == NULL)
+		fprintf(stderr, "Error : sliced_bloom_insert -> sliced is NULL\n");
+	assert(sliced != NULL);
+
+	for (int i = 0; i < sliced->num_of_hashes; i++)
+		row(sliced, hash, i)[set / 8] |= 1 << (set % 8);
+}
+
+bool sliced_bloom_check(SlicedBloom sliced, uint64_t hash, uint8_t * sets)
+{
+	if (sliced == NULL)
+		fprintf(stderr, "Error : sliced_bloom_check -> sliced is NULL\n");
+	assert(sliced != NULL);
+
+	// the k rows of the key are ANDed a word at a time, and the check stops as soon as no set is left
+	int num_of_words = (sliced->row_size + 7) / 8;
+	int word_size = (sliced->row_size < 8) ? sliced->row_size : 8;
+	bool any = true;
+	memset(sets, 0xFF, sliced->row_size);
+	for (int i = 0; i < sliced->num_of_hashes && any; i++)
+	{
+		uint8_t * bits = row(sliced, hash, i);
+		any = false;
+		for (int w = 0; w < num_of_words; w++)
+		{
+			uint64_t word = 0, result = 0;
+			memcpy(&word, bits + 8 * w, word_size);
+			memcpy(&result, sets + 8 * w, word_size);
+			result &= word;
+			memcpy(sets + 8 * w, &result, word_size);
+			any |= (result != 0);
+		}
+	}
+	return any;
+}
+
+int sliced_bloom_sets(SlicedBloom sliced)
+{
+	return 8 * sliced->row_size;
+}
+
+int sliced_bloom_row_size(SlicedBloom sliced)
+{
+	return sliced->row_size;
+}
+
+int sliced_bloom_hashes(SlicedBloom sliced)
+{
+	return sliced->num_of_hashes;
+}
+
+unsigned long sliced_bloom_memory(SlicedBloom sliced)
+{
+	return sliced->num_of_positions * sliced->row_size;
+}
+
+void sliced_bloom_destroy(SlicedBloom sliced)
+{
+	if (sliced == NULL)
+		fprintf(stderr, "Error : sliced_bloom_destroy -> sliced is NULL\n");
+	assert(sliced != NULL);
+
+	free(sliced->rows);
+	free(sliced);
+}
@@ -0,0 +1,25 @@
+/*file : sliced_bloom.h*/
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct sliced_bloom* SlicedBloom;
+
+/* creates a bit-sliced bloom filter of given number of bit positions and hash functions, for (at least) given number of sets of keys, returns a pointer to the structure.
+   Each bit position is a row of one bit per set, so that the k rows of a key, ANDed together, tell which sets may have it */
+SlicedBloom sliced_bloom_create(unsigned long num_of_positions, int num_of_hashes, int num_of_sets);
+/* inserts the key of given 64 bit hash into given set (0 <= set < sliced_bloom_sets) */
+void sliced_bloom_insert(SlicedBloom sliced, int set, uint64_t hash);
+/* writes into sets (sliced_bloom_row_size bytes) the bitmap of the sets that may have the key of given 64 bit hash : bit (set % 8) of byte (set / 8).
+   Returns false if no set has it */
+bool sliced_bloom_check(SlicedBloom sliced, uint64_t hash, uint8_t * sets);
+/* returns the number of sets a row has room for */
+int sliced_bloom_sets(SlicedBloom sliced);
+/* returns the size in bytes of a row (of the bitmap written by sliced_bloom_check) */
+int sliced_bloom_row_size(SlicedBloom sliced);
+/* returns the number of hash functions of the filter */
+int sliced_bloom_hashes(SlicedBloom sliced);
+/* returns the size in bytes of the rows of the filter */
+unsigned long sliced_bloom_memory(SlicedBloom sliced);
+/* deletes bit-sliced bloom filter data structure */
+void sliced_bloom_destroy(SlicedBloom sliced);
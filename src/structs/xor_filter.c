@@ -0,0 +1,198 @@
+/*file : xor_filter.c*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "xor_filter.h"
+#include <assert.h>
+
+// data struct for xor filter : the fingerprint of a key is the xor of its 3 slots, one in each third of the array
+struct xor_filter {
+	uint8_t * fingerprints;
+	unsigned long block_length;		// number of slots of each third
+	uint64_t seed;					// seed the hashes of the keys are mixed with, for which building the filter succeeded
+	unsigned long count;
+};
+
+/* mixes the hash of a key with the seed of the filter (murmur3 finalizer) */
+static uint64_t mix(uint64_t hash, uint64_t seed)
+{
+	hash += seed;
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdULL;
+	hash ^= hash >> 33;
+	hash *= 0xc4ceb9fe1a85ec53ULL;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+static uint8_t fingerprint(uint64_t hash)
+{
+	return (uint8_t) (hash ^ (hash >> 32));
+}
+
+/* slot of a key in given third of the array : a different 32 bits of its mixed hash for each third (multiply and shift instead of a modulo) */
+static unsigned long slot(XorFilter filter, uint64_t hash, int third)
+{
+	uint32_t bits = (uint32_t) ((third == 0) ? hash : (hash << (21 * third)) | (hash >> (64 - 21 * third)));
+	return third * filter->block_length + (((uint64_t) bits * filter->block_length) >> 32);
+}
+
+static int hash_cmp(const void * a, const void * b)
+{
+	uint64_t hash_a = *(const uint64_t *) a;
+	uint64_t hash_b = *(const uint64_t *) b;
+	return (hash_a > hash_b) - (hash_a < hash_b);
+}
+
+/* a slot with the number of keys mapped to it, and the xor of their mixed hashes (the hash of the key when a single one is left) */
+struct slot_keys {
+	uint64_t hashes;
+	uint32_t count;
+};
+
+/* a key removed from the slot it was the only key of, in the order of removal */
+struct peeled {
+	uint64_t hash;
+	unsigned long slot;
+};
+
+XorFilter xor_create(uint64_t * hashes, unsigned long num_of_keys)
+{
+	XorFilter filter = malloc(sizeof(*filter));
+	if (filter == NULL)
+		fprintf(stderr, "Error : xor_create -> malloc\n");
+	assert(filter != NULL);
+
+	// a key given twice could never be peeled, so duplicate hashes are removed first
+	qsort(hashes, num_of_keys, sizeof(uint64_t), hash_cmp);
+	unsigned long unique = 0;
+	for (unsigned long i = 0; i < num_of_keys; i++)
+	{
+		if (unique == 0 || hashes[i] != hashes[unique - 1])
+			hashes[unique++] = hashes[i];
+	}
+	num_of_keys = unique;
+
+	// 1.23 slots per key are enough for the peeling to succeed with high probability
+	unsigned long capacity = 32 + (unsigned long) (1.23 * num_of_keys);
+	filter->block_length = capacity / 3;
+	filter->count = num_of_keys;
+	capacity = 3 * filter->block_length;
+
+	filter->fingerprints = calloc(capacity, sizeof(uint8_t));
+	struct slot_keys * slots = malloc(capacity * sizeof(struct slot_keys));
+	unsigned long * queue = malloc(capacity * sizeof(unsigned long));
+	struct peeled * stack = malloc((num_of_keys + 1) * sizeof(struct peeled));
+	if (filter->fingerprints == NULL || slots == NULL || queue == NULL || stack == NULL)
+		fprintf(stderr, "Error : xor_create -> malloc\n");
+	assert(filter->fingerprints != NULL && slots != NULL && queue != NULL && stack != NULL);
+
+	unsigned long num_of_peeled = 0;
+	for (filter->seed = 0x9E3779B97F4A7C15ULL; ; filter->seed += 0x9E3779B97F4A7C15ULL)
+	{
+		memset(slots, 0, capacity * sizeof(struct slot_keys));
+		for (unsigned long i = 0; i < num_of_keys; i++)
+		{
+			uint64_t hash = mix(hashes[i], filter->seed);
+			for (int third = 0; third < 3; third++)
+			{
+				unsigned long s = slot(filter, hash, third);
+				slots[s].hashes ^= hash;
+				slots[s].count++;
+			}
+		}
+
+		// a slot of a single key is given to that key, which is then removed from its other two slots, possibly leaving them with a single key as well
+		unsigned long queue_size = 0;
+		for (unsigned long s = 0; s < capacity; s++)
+		{
+			if (slots[s].count == 1)
+				queue[queue_size++] = s;
+		}
+
+		num_of_peeled = 0;
+		while (queue_size > 0)
+		{
+			unsigned long s = queue[--queue_size];
+			if (slots[s].count != 1)
+				continue;
+
+			uint64_t hash = slots[s].hashes;
+			stack[num_of_peeled].hash = hash;
+			stack[num_of_peeled++].slot = s;
+			for (int third = 0; third < 3; third++)
+			{
+				unsigned long other = slot(filter, hash, third);
+				slots[other].hashes ^= hash;
+				if (--slots[other].count == 1)
+					queue[queue_size++] = other;
+			}
+		}
+
+		if (num_of_peeled == num_of_keys)		// every key was given a slot of its own
+			break;
+	}
+
+	// in reverse order of removal, the fingerprint of a key is stored into its own slot, as the xor with its other two slots (which are final by then)
+	while (num_of_peeled > 0)
+	{
+		struct peeled * key = &stack[--num_of_peeled];
+		uint8_t fp = fingerprint(key->hash);
+		for (int third = 0; third < 3; third++)
+		{
+			unsigned long s = slot(filter, key->hash, third);
+			if (s != key->slot)
+				fp ^= filter->fingerprints[s];
+		}
+		filter->fingerprints[key->slot] = fp;
+	}
+
+	free(slots);
+	free(queue);
+	free(stack);
+
+	return filter;
+}
+
+bool xor_check(XorFilter filter, uint64_t hash)
+{
+	if (filter == NULL)
+		fprintf(stderr, "Error : xor_check -> filter is NULL\n");
+	assert(filter != NULL);
+
+	// three loads, whatever the number of keys or the false positive rate (about 1/256)
+	hash = mix(hash, filter->seed);
+	uint8_t fp = fingerprint(hash);
+	return fp == (filter->fingerprints[slot(filter, hash, 0)] ^ filter->fingerprints[slot(filter, hash, 1)] ^ filter->fingerprints[slot(filter, hash, 2)]);
+}
+
+void xor_prefetch(XorFilter filter, uint64_t hash)
+{
+	if (filter == NULL)
+		fprintf(stderr, "Error : xor_prefetch -> filter is NULL\n");
+	assert(filter != NULL);
+
+	hash = mix(hash, filter->seed);
+	for (int third = 0; third < 3; third++)
+		__builtin_prefetch(&filter->fingerprints[slot(filter, hash, third)]);
+}
+
+unsigned long xor_count(XorFilter filter)
+{
+	return filter->count;
+}
+
+unsigned long xor_memory(XorFilter filter)
+{
+	return 3 * filter->block_length * sizeof(uint8_t);
+}
+
+void xor_destroy(XorFilter filter)
+{
+	if (filter == NULL)
+		fprintf(stderr, "Error : xor_destroy -> filter is NULL\n");
+	assert(filter != NULL);
+
+	free(filter->fingerprints);
+	free(filter);
+}
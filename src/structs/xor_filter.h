@@ -0,0 +1,20 @@
+/*file : xor_filter.h*/
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct xor_filter* XorFilter;
+
+/* builds an xor filter of 8 bit fingerprints from the keys of given 64 bit hashes (the array is sorted in place), returns a pointer to the structure.
+   The filter is immutable : no key can be inserted into it or deleted from it after it is built */
+XorFilter xor_create(uint64_t * hashes, unsigned long num_of_keys);
+/* checks if the key of given 64 bit hash may be in the filter */
+bool xor_check(XorFilter filter, uint64_t hash);
+/* prefetches the three slots a later check of the key of given 64 bit hash reads */
+void xor_prefetch(XorFilter filter, uint64_t hash);
+/* returns the number of keys the filter was built from */
+unsigned long xor_count(XorFilter filter);
+/* returns the size in bytes of the fingerprints of the filter */
+unsigned long xor_memory(XorFilter filter);
+/* deletes xor filter data structure */
+void xor_destroy(XorFilter filter);
@@ -3,272 +3,594 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include "monitor.h"
+#include "loader.h"
+#include "snapshot.h"
+#include "tail.h"
+#include "query_pool.h"
 #include <string.h>
 #include <time.h>
+#include <poll.h>
+#include <unistd.h>
 
-int main(int argc, char const *argv[])
+#define PROMPT "Waiting for command/task >>  "
+#define BENCHMARK_QUERIES 100000		// queries of /readBenchmark, if not given
+
+/* returns true if the command is a query, that only reads the monitor (vaccineStatusBloom, vaccineStatus, vaccineStatusBatch, populationStatus, popStatusByAge) */
+static bool is_query(const char * command)
 {
-	/*check for correct arg input from terminal*/
-	if (argc != 5)
+	const char * queries[] = { "/vaccineStatusBloom", "/vaccineStatus", "/vaccineStatusBatch", "/populationStatus", "/popStatusByAge" };
+	command += strspn(command, " ");
+	size_t length = strcspn(command, " ");
+	for (int i = 0; i < 5; i++)
 	{
-		fprintf(stderr, "Error: wrong number of args\nUse: ./vaccineMonitor -c citizenRecordsFile -b bloomSize\n");
-		exit(EXIT_FAILURE);
+		if (strlen(queries[i]) == length && !strncmp(command, queries[i], length))
+			return true;
 	}
+	return false;
+}
+
+/* returns true if the command reads from stdin (a batch of ids that follow the command), so that it cannot run in parallel with the reading of the next commands */
+static bool reads_stdin(const char * command)
+{
+	size_t length = strlen(command);
+	return length >= 2 && !strcmp(command + length - 2, " -");
+}
 
-	if (strcmp(argv[1], "-c") != 0 || strcmp(argv[3], "-b") != 0)
+/* runs a query, writing its output into out. Arguments are split with strtok_r, so that queries can run on several threads at once */
+static void run_query(Monitor vaccine_monitor, char * input, FILE * out)
+{
+	char * citizenID, * virusName;
+	char * saveptr;
+	char *str = strtok_r(input, " ", &saveptr);
+	if (str == NULL)
+		return;
+
+	if (!strcmp(str, "/vaccineStatusBloom"))
 	{
-		fprintf(stderr, "Error: one or more wrong input parameters\n Use : -c -b\n");
-		exit(EXIT_FAILURE);
+		int i = 0;
+		virusName = NULL;
+		while(str != NULL)
+		{
+			switch (i)
+			{
+				case 1: citizenID = str; break;
+				case 2: virusName = str; break;
+			}
+
+			i++;
+			str = strtok_r(NULL, " ", &saveptr);
+		}
+
+		if (i != 3 && i != 2)
+			fprintf(out, "Error : unknown or invalid command\n\n");
+		else
+			vaccineStatusBloom(vaccine_monitor, citizenID, virusName, out);
 	}
 
-	unsigned int bloom_size = atoi(argv[4]);
-	if (!bloom_size)
+	else if (!strcmp(str, "/vaccineStatus"))
 	{
-		fprintf(stderr, "Error: invalid input parameter bloomSize\n Use : positive integer\n");
+		int i = 0;
+		virusName = NULL;
+		while(str != NULL)
+		{
+			switch (i)
+			{
+				case 1: citizenID = str; break;
+				case 2: virusName = str; break;
+			}
+
+			i++;
+			str = strtok_r(NULL, " ", &saveptr);
+		}
+
+		if (i != 3 && i != 2)
+			fprintf(out, "Error : unknown or invalid command\n\n");
+		else
+			vaccineStatus(vaccine_monitor, citizenID, virusName, out);
+	}
+
+	else if (!strcmp(str, "/vaccineStatusBatch"))
+	{
+		int i = 0;
+		char * path;
+		while(str != NULL)
+		{
+			switch (i)
+			{
+				case 1: virusName = str; break;
+				case 2: path = str; break;
+			}
+
+			i++;
+			str = strtok_r(NULL, " ", &saveptr);
+		}
+
+		if (i != 3)
+			fprintf(out, "Error : unknown or invalid command\n\n");
+		else if (!strcmp(path, "-"))		// ids follow the command, up to an empty line
+			vaccineStatusBatch(vaccine_monitor, virusName, stdin, out);
+		else
+		{
+			FILE * ids_file = fopen(path, "r");
+			if (ids_file == NULL)
+				fprintf(out, "Error : vaccineStatusBatch -> could not open file %s\n\n", path);
+			else
+			{
+				vaccineStatusBatch(vaccine_monitor, virusName, ids_file, out);
+				fclose(ids_file);
+			}
+		}
+	}
+
+	else if (!strcmp(str, "/populationStatus") || !strcmp(str, "/popStatusByAge"))
+	{
+		// both take [country] virusName [date1 date2]
+		void (*query)(Monitor, char *, char *, char *, char *, FILE *) = !strcmp(str, "/populationStatus") ? populationStatus : popStatusByAge;
+		int i = 0;
+		char * arg1, * arg2, * arg3, * arg4;
+		while(str != NULL)
+		{
+			switch (i)
+			{
+				case 1: arg1 = str; break;
+				case 2: arg2 = str; break;
+				case 3: arg3 = str; break;
+				case 4: arg4 = str; break;
+			}
+
+			i++;
+			str = strtok_r(NULL, " ", &saveptr);
+		}
+
+		if (i != 2 && i != 3 && i != 4 && i != 5)
+			fprintf(out, "Error : unknown or invalid command\n\n");
+		else if (i == 2)
+			query(vaccine_monitor, NULL, arg1, NULL, NULL, out);
+		else if (i == 3)
+			query(vaccine_monitor, arg1, arg2, NULL, NULL, out);
+		else if (i == 4)
+			query(vaccine_monitor, NULL, arg1, arg2, arg3, out);
+		else if (i == 5)
+			query(vaccine_monitor, arg1, arg2, arg3, arg4, out);
+	}
+}
+
+/* applies the records appended to the followed files, with no query running meanwhile if queries run on a pool of threads */
+static void apply_followed(Tail tail, Monitor vaccine_monitor, QueryPool pool)
+{
+	if (pool != NULL)
+		query_pool_pause(pool);
+	tail_apply(tail, vaccine_monitor);
+	if (pool != NULL)
+		query_pool_resume(pool);
+}
+
+int main(int argc, char const *argv[])
+{
+	const char * records_file = NULL;
+	const char * snapshot_file = NULL;
+	const char * wal_file = NULL;
+	const char * follow_path = NULL;
+	int group_commit_ms = 10;
+	unsigned int bloom_size = 0;
+	int bloom_layout = -1;
+	double bloom_fpr = 0;
+	bool bloom_scalable = false;
+	int filter_kind = -1;
+	bool bloom_sliced = false;
+	bool use_mmap = false;
+	int num_of_threads = 1;
+	int num_of_query_threads = 0;
+
+	/*check for correct arg input from terminal*/
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "-c") && i + 1 < argc)
+			records_file = argv[++i];
+		else if (!strcmp(argv[i], "-b") && i + 1 < argc)
+		{
+			bloom_size = atoi(argv[++i]);
+			if (!bloom_size)
+			{
+				fprintf(stderr, "Error: invalid input parameter bloomSize\n Use : positive integer\n");
+				exit(EXIT_FAILURE);
+			}
+		}
+		else if (!strcmp(argv[i], "-r") && i + 1 < argc)
+		{
+			char * end;
+			bloom_fpr = strtod(argv[++i], &end);
+			if (*end != '\0' || bloom_fpr <= 0 || bloom_fpr >= 1)
+			{
+				fprintf(stderr, "Error: invalid input parameter falsePositiveRate\n Use : number between 0 and 1\n");
+				exit(EXIT_FAILURE);
+			}
+		}
+		else if (!strcmp(argv[i], "-S"))
+			bloom_scalable = true;
+		else if (!strcmp(argv[i], "-a"))
+			bloom_sliced = true;
+		else if (!strcmp(argv[i], "-l") && i + 1 < argc)
+		{
+			bloom_layout = bloom_layout_parse(argv[++i]);
+			if (bloom_layout == -1)
+			{
+				fprintf(stderr, "Error: invalid input parameter bloomLayout\n Use : classic or blocked\n");
+				exit(EXIT_FAILURE);
+			}
+		}
+		else if (!strcmp(argv[i], "-k") && i + 1 < argc)
+		{
+			filter_kind = filter_kind_parse(argv[++i]);
+			if (filter_kind == -1)
+			{
+				fprintf(stderr, "Error: invalid input parameter filterKind\n Use : bloom, cuckoo or xor\n");
+				exit(EXIT_FAILURE);
+			}
+		}
+		else if (!strcmp(argv[i], "-s") && i + 1 < argc)
+			snapshot_file = argv[++i];
+		else if (!strcmp(argv[i], "-w") && i + 1 < argc)
+			wal_file = argv[++i];
+		else if (!strcmp(argv[i], "-g") && i + 1 < argc)
+		{
+			char * end;
+			group_commit_ms = strtol(argv[++i], &end, 10);
+			if (*end != '\0' || group_commit_ms < 0)
+			{
+				fprintf(stderr, "Error: invalid input parameter groupCommitMs\n Use : non negative integer\n");
+				exit(EXIT_FAILURE);
+			}
+		}
+		else if (!strcmp(argv[i], "-f") && i + 1 < argc)
+			follow_path = argv[++i];
+		else if (!strcmp(argv[i], "-m"))
+			use_mmap = true;
+		else if (!strcmp(argv[i], "-t") && i + 1 < argc)
+		{
+			num_of_threads = atoi(argv[++i]);
+			if (num_of_threads < 1)
+			{
+				fprintf(stderr, "Error: invalid input parameter numThreads\n Use : positive integer\n");
+				exit(EXIT_FAILURE);
+			}
+		}
+		else if (!strcmp(argv[i], "-q") && i + 1 < argc)
+		{
+			num_of_query_threads = atoi(argv[++i]);
+			if (num_of_query_threads < 1)
+			{
+				fprintf(stderr, "Error: invalid input parameter numQueryThreads\n Use : positive integer\n");
+				exit(EXIT_FAILURE);
+			}
+		}
+		else
+		{
+			fprintf(stderr, "Error: one or more wrong input parameters\n Use : -c -b|-r [-S] [-a] [-l bloomLayout] [-k filterKind] [-s snapshotFile] [-w walFile [-g groupCommitMs]] [-f followPath] [-m] [-t numThreads] [-q numQueryThreads]\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	if (bloom_scalable && bloom_fpr == 0)
+		bloom_fpr = 0.01;		// scalable bloom filters are of a target false positive rate, 1% if none is given
+
+	// a snapshot keeps the bloom size it was saved with, so with -s both -c and -b are optional (-r sizes each bloom filter instead of -b, and cuckoo or xor filters need neither)
+	bool filter_sized = bloom_size || bloom_fpr != 0 || (filter_kind != -1 && filter_kind != FILTER_BLOOM);
+	if ((records_file == NULL || !filter_sized) && snapshot_file == NULL)
+	{
+		fprintf(stderr, "Error: wrong number of args\nUse: ./vaccineMonitor -c citizenRecordsFile (-b bloomSize | -r falsePositiveRate | -k filterKind) [-S] [-a] [-l bloomLayout] [-s snapshotFile] [-w walFile [-g groupCommitMs]] [-f followPath] [-m] [-t numThreads] [-q numQueryThreads]\n");
 		exit(EXIT_FAILURE);
 	}
 
 	srand((unsigned int)time(NULL));
 
-	char * line = NULL;
 	char * citizenID , * firstName, * lastName, * country, * virusName, * vacc, * date;
 	int age;
-    size_t length = 0;
 
-    Monitor vaccine_monitor = monitor_create(bloom_size, 8, 0.5);
+    struct timespec load_start, load_end;
+    Monitor vaccine_monitor;
+
     printf("\nInitializing monitor\n");
-    printf("Inserting input file data into monitor\n\n");
+    if (snapshot_file != NULL)
+    {
+    	clock_gettime(CLOCK_MONOTONIC, &load_start);
+    	vaccine_monitor = monitor_restore(snapshot_file);
+	    if (vaccine_monitor == NULL)
+	    {
+		    fprintf(stderr, "Error: main->could not restore snapshot\n");
+		    exit(EXIT_FAILURE);
+	    }
+	    if (bloom_size)
+	    	set_bloom_size(vaccine_monitor, bloom_size);		// bloom size of viruses created from now on
+	    if (bloom_layout != -1)
+	    	set_bloom_layout(vaccine_monitor, bloom_layout);	// restored viruses keep the layout they were saved with
+	    if (bloom_fpr != 0)
+	    	set_bloom_fpr(vaccine_monitor, bloom_fpr);
+	    if (bloom_scalable)
+	    	set_bloom_scalable(vaccine_monitor, true);
+	    if (filter_kind != -1)
+	    	set_filter_kind(vaccine_monitor, filter_kind);	// restored viruses keep the kind of filter they were saved with
+    	clock_gettime(CLOCK_MONOTONIC, &load_end);
+    	printf("Restored snapshot %s in %.3f sec\n\n", snapshot_file, (load_end.tv_sec - load_start.tv_sec) + (load_end.tv_nsec - load_start.tv_nsec) / 1e9);
+    }
+    else
+    {
+    	vaccine_monitor = monitor_create(bloom_size, 8, 0.5);
+    	if (bloom_layout != -1)
+    		set_bloom_layout(vaccine_monitor, bloom_layout);
+    	set_bloom_fpr(vaccine_monitor, bloom_fpr);
+    	set_bloom_scalable(vaccine_monitor, bloom_scalable);
+    	if (filter_kind != -1)
+    		set_filter_kind(vaccine_monitor, filter_kind);
+    }
+    if (bloom_sliced)
+    	set_bloom_sliced(vaccine_monitor, true);		// built from the restored viruses, and again once the records file is loaded
+
+    if (records_file != NULL)
+    {
+	    printf("Inserting input file data into monitor\n\n");
+	    clock_gettime(CLOCK_MONOTONIC, &load_start);
+
+	    /* -t : map the file and parse chunks of it in parallel, -m : map the file and parse records in place, otherwise read it line by line */
+	    long num_of_lines;
+	    monitor_bulk_begin(vaccine_monitor);
+	    if (num_of_threads > 1)
+	    	num_of_lines = loader_parallel_file(vaccine_monitor, records_file, num_of_threads);
+	    else if (use_mmap)
+	    	num_of_lines = loader_mmap_file(vaccine_monitor, records_file);
+	    else
+	    	num_of_lines = loader_read_file(vaccine_monitor, records_file);
+	    if (num_of_lines == -1)
+	    {
+		    fprintf(stderr, "Error: main->could not load citizen records file\n");
+		    exit(EXIT_FAILURE);
+    }
+
+	    monitor_bulk_end(vaccine_monitor, num_of_threads);
+	    clock_gettime(CLOCK_MONOTONIC, &load_end);
+	    double load_secs = (load_end.tv_sec - load_start.tv_sec) + (load_end.tv_nsec - load_start.tv_nsec) / 1e9;
+	    printf("Loaded %ld lines in %.3f sec (%.0f lines/sec)\n\n", num_of_lines, load_secs, (load_secs > 0) ? num_of_lines / load_secs : 0.0);
+    }
+	
+	//monitor_print(vaccine_monitor);
 
-    FILE *file_ptr;
-	file_ptr = fopen(argv[2], "r");  /*open citizen records txt file , in read mode*/
-	if (file_ptr == NULL)
+	Wal wal = NULL;
+	if (wal_file != NULL)
 	{
-	    fprintf(stderr, "Error: main->fopen, could not open file\n");
-	    exit(EXIT_FAILURE);
+		// mutations logged since the base records file (or snapshot) are applied on top of it
+		clock_gettime(CLOCK_MONOTONIC, &load_start);
+		long num_of_records = loader_replay_wal(vaccine_monitor, wal_file);
+		if (num_of_records == -1)
+		{
+			fprintf(stderr, "Error: main->could not replay write-ahead log\n");
+			exit(EXIT_FAILURE);
+		}
+		clock_gettime(CLOCK_MONOTONIC, &load_end);
+		if (num_of_records > 0)
+			printf("Replayed %ld logged mutations in %.3f sec\n\n", num_of_records, (load_end.tv_sec - load_start.tv_sec) + (load_end.tv_nsec - load_start.tv_nsec) / 1e9);
+
+		wal = wal_open(wal_file, group_commit_ms);
+		if (wal == NULL)
+			exit(EXIT_FAILURE);
+		monitor_set_wal(vaccine_monitor, wal);
 	}
-	else    /*following block of code reads from the file and inserts the entries of file*/
-	{
-	  	while(getline(&line, &length, file_ptr) != -1)
-	    {
-	    	date = NULL;
-	    	line[strlen(line)-1] = '\0';		// remove newline character from line read from file
-	      	char *str = strtok(line, " ");
-	      	int i = 1;
-	      	while(str != NULL)
-	      	{
-	         	switch (i)
-	         	{
-	         		case 1: citizenID = str; break;
-	         		case 2: firstName = str; break;
-	         		case 3: lastName = str; break;
-	         		case 4: country = str; break;
-	         		case 5: age = atoi(str); break;
-	         		case 6: virusName = str; break;
-	         		case 7: vacc = str; break;
-	         		case 8: date = str; break;
-	         	}
-
-	         	// check if citizenID is a duplicate (same citizenID and virusName)
-	 			// if that's the case, discard the record
-	         	
-	         	//printf("%s ", str);
-	         	i++;
-	         	str = strtok(NULL, " ");
-	      	}
-	      	//printf("\n");
-	      	//printf("Inserting Record into the monitor\n");
-	      	monitor_insert(vaccine_monitor, citizenID, firstName, lastName, country, age, virusName, vacc, date);
-	     
-	     }
 
-	    free(line);
+	Tail tail = NULL;
+	if (follow_path != NULL)
+	{
+		tail = tail_start(follow_path);
+		if (tail == NULL)
+			exit(EXIT_FAILURE);
+		setvbuf(stdin, NULL, _IONBF, 0);		// so that a waiting command is always seen by poll, and not hidden in the buffer of stdin
 	}
-	
-	//monitor_print(vaccine_monitor);
+
+	// -q : queries run on a pool of threads, in parallel with each other and with the reading of the next commands, and the other commands run alone.
+	// The output of a query is followed by the prompt of the next command, so the prompt is printed here only after the other commands
+	QueryPool pool = NULL;
+	if (num_of_query_threads > 0)
+		pool = query_pool_create(vaccine_monitor, num_of_query_threads, run_query, PROMPT);
 
 	bool exit = false;
+	bool prompt = true;
 	char input[100];
 	while (exit == false)
 	{
-		printf("Waiting for command/task >>  ");
-		fgets(input, 100, stdin);
-		if (!strcmp(input, "\n"))
-			continue;
+		if (prompt)
+			printf(PROMPT);
+		prompt = true;
+		if (tail != NULL)
+		{
+			// while waiting for the next command, apply records appended to the followed files
+			fflush(stdout);
+			struct pollfd fds[2];
+			fds[0].fd = STDIN_FILENO;
+			fds[0].events = POLLIN;
+			fds[1].fd = tail_fd(tail);
+			fds[1].events = POLLIN;
+			while (poll(fds, 2, -1) > 0 && !fds[0].revents)
+				apply_followed(tail, vaccine_monitor, pool);
+			apply_followed(tail, vaccine_monitor, pool);
+		}
+		if (fgets(input, 100, stdin) == NULL)
+			strcpy(input, "/exit\n");		// end of input
 		input[strlen(input)-1] = '\0';		// remove newline character from line read from command line
 
-		if (!strcmp(input, "/exit"))
+		if (pool != NULL && (is_query(input) || input[0] == '\0') && !reads_stdin(input))
 		{
+			query_pool_submit(pool, input);		// an empty line is a query of no output, to keep the prompts in order
+			prompt = false;
+			continue;
+		}
+		if (input[0] == '\0')
+			continue;
+
+		// a benchmark runs queries on threads of its own, so it only waits for the queries before it
+		bool benchmark = !strncmp(input, "/readBenchmark", strlen("/readBenchmark"));
+		if (pool != NULL && benchmark)
+			query_pool_drain(pool);
+		else if (pool != NULL)
+			query_pool_pause(pool);
+
+		if (is_query(input))
+			run_query(vaccine_monitor, input, stdout);
+		else if (!strcmp(input, "/exit"))
+		{
+			if (pool != NULL)
+			{
+				query_pool_resume(pool);
+				query_pool_destroy(pool);
+				pool = NULL;
+			}
+			if (tail != NULL)
+				tail_stop(tail);
+			if (wal != NULL)
+				wal_close(wal);
 			exit_monitor(vaccine_monitor);
 			exit = true;
 		}
 		else
 		{
 			char *str = strtok(input, " ");
-	      	if (!strcmp(str, "/vaccineStatusBloom"))
+	      	if (!strcmp(str, "/insertCitizenRecord"))
 	      	{
 	      		int i = 0;
+	      		date = NULL;
 	      		while(str != NULL)
 	      		{
 	         		switch (i)
 	         		{
 	         			case 1: citizenID = str; break;
-	         			case 2: virusName = str; break;
+	         			case 2: firstName = str; break;
+	         			case 3: lastName = str; break;
+	         			case 4: country = str; break;
+	         			case 5: age = atoi(str); break;
+	         			case 6: virusName = str; break;
+	         			case 7: vacc = str; break;
+	         			case 8: date = str; break;
 	         		}
-
+	         
 	         		i++;
 	         		str = strtok(NULL, " ");
 	      		}
 
-	      		if (i != 3)
+	      		if (i != 8 && i != 9)
 	      			printf("Error : unknown or invalid command\n\n");
 	      		else
-	      			vaccineStatusBloom(vaccine_monitor, citizenID, virusName);
+	      			insertCitizenRecord(vaccine_monitor, citizenID, firstName, lastName, country, age, virusName, vacc, date);
 	      	}
 
-	      	else if (!strcmp(str, "/vaccineStatus"))
+	      	else if (!strcmp(str, "/vaccinateNow"))
 	      	{
 	      		int i = 0;
-	      		virusName = NULL;
 	      		while(str != NULL)
 	      		{
 	         		switch (i)
 	         		{
 	         			case 1: citizenID = str; break;
-	         			case 2: virusName = str; break;
+	         			case 2: firstName = str; break;
+	         			case 3: lastName = str; break;
+	         			case 4: country = str; break;
+	         			case 5: age = atoi(str); break;
+	         			case 6: virusName = str; break;	         	
 	         		}
-
+	         
 	         		i++;
 	         		str = strtok(NULL, " ");
 	      		}
 
-	      		if (i != 3 && i != 2)
+	      		if (i != 7)
 	      			printf("Error : unknown or invalid command\n\n");
-	      		else	  
-	      			vaccineStatus(vaccine_monitor, citizenID, virusName);
+	      		else
+	      			vaccinateNow(vaccine_monitor, citizenID, firstName, lastName, country, age, virusName);
 	      	}
 
-	      	else if (!strcmp(str, "/populationStatus"))
+	      	else if (!strcmp(str, "/list-nonVaccinated-Persons"))
 	      	{
-	      		int i = 0;
-	      		char * arg1, * arg2, * arg3, * arg4;
+	      		int i = 0;	      
 	      		while(str != NULL)
 	      		{
 	         		switch (i)
 	         		{
-	         			case 1: arg1 = str; break;
-	         			case 2: arg2 = str; break;
-	         			case 3: arg3 = str; break;
-	         			case 4: arg4 = str; break;
+	         			case 1: virusName = str; break;
 	         		}
-	         
+
 	         		i++;
 	         		str = strtok(NULL, " ");
 	      		}
 
-	      		if (i != 2 && i != 3 && i != 4 && i != 5)
+	      		if (i != 2)
 	      			printf("Error : unknown or invalid command\n\n");
-	      		else if (i == 2)
-	      			populationStatus(vaccine_monitor, NULL, arg1, NULL, NULL);
-	      		else if (i == 3)
-	      			populationStatus(vaccine_monitor, arg1, arg2, NULL, NULL);
-	      		else if (i == 4)
-	      			populationStatus(vaccine_monitor, NULL, arg1, arg2, arg3);
-	      		else if (i == 5)
-	      			populationStatus(vaccine_monitor, arg1, arg2, arg3, arg4);
-
+	      		else	  
+	      			list_nonVaccinated_Persons(vaccine_monitor, virusName);
 	      	}
 
-	      	else if (!strcmp(str, "/popStatusByAge"))
+	      	else if (!strcmp(str, "/memoryReport"))
+	      		memory_report(vaccine_monitor);
+
+	      	else if (!strcmp(str, "/bloomStats"))
+	      		bloom_stats(vaccine_monitor);
+
+	      	else if (!strcmp(str, "/readBenchmark"))
 	      	{
 	      		int i = 0;
-	      		char * arg1, * arg2, * arg3, * arg4;
+	      		int num_of_queries = BENCHMARK_QUERIES;
 	      		while(str != NULL)
 	      		{
 	         		switch (i)
 	         		{
-	         			case 1: arg1 = str; break;
-	         			case 2: arg2 = str; break;
-	         			case 3: arg3 = str; break;
-	         			case 4: arg4 = str; break;
+	         			case 1: num_of_queries = atoi(str); break;
 	         		}
-	         
+
 	         		i++;
 	         		str = strtok(NULL, " ");
 	      		}
 
-	      		if (i != 2 && i != 3 && i != 4 && i != 5)
+	      		// up to as many threads as the query pool has, or as there are cores
+	      		int max_threads = (num_of_query_threads > 0) ? num_of_query_threads : sysconf(_SC_NPROCESSORS_ONLN);
+	      		if ((i != 1 && i != 2) || num_of_queries < 1)
 	      			printf("Error : unknown or invalid command\n\n");
-	      		else if (i == 2)
-	      			popStatusByAge(vaccine_monitor, NULL, arg1, NULL, NULL);
-	      		else if (i == 3)
-	      			popStatusByAge(vaccine_monitor, arg1, arg2, NULL, NULL);
-	      		else if (i == 4)
-	      			popStatusByAge(vaccine_monitor, NULL, arg1, arg2, arg3);
-	      		else if (i == 5)
-	      			popStatusByAge(vaccine_monitor, arg1, arg2, arg3, arg4);
+	      		else
+	      			read_benchmark(vaccine_monitor, num_of_queries, (max_threads > 0) ? max_threads : 1);
 	      	}
 
-	      	else if (!strcmp(str, "/insertCitizenRecord"))
+	      	else if (!strcmp(str, "/bloomBenchmark"))
 	      	{
 	      		int i = 0;
-	      		date = NULL;
+	      		int num_of_keys = hash_size(get_citizens_index(vaccine_monitor));		// as many keys as citizens, if not given
 	      		while(str != NULL)
 	      		{
 	         		switch (i)
 	         		{
-	         			case 1: citizenID = str; break;
-	         			case 2: firstName = str; break;
-	         			case 3: lastName = str; break;
-	         			case 4: country = str; break;
-	         			case 5: age = atoi(str); break;
-	         			case 6: virusName = str; break;
-	         			case 7: vacc = str; break;
-	         			case 8: date = str; break;
+	         			case 1: num_of_keys = atoi(str); break;
 	         		}
-	         
+
 	         		i++;
 	         		str = strtok(NULL, " ");
 	      		}
 
-	      		if (i != 8 && i != 9)
+	      		if ((i != 1 && i != 2) || num_of_keys < 1)
 	      			printf("Error : unknown or invalid command\n\n");
 	      		else
-	      			insertCitizenRecord(vaccine_monitor, citizenID, firstName, lastName, country, age, virusName, vacc, date);
+	      			bloom_benchmark(vaccine_monitor, num_of_keys);
 	      	}
 
-	      	else if (!strcmp(str, "/vaccinateNow"))
+	      	else if (!strcmp(str, "/ingestStats"))
 	      	{
-	      		int i = 0;
-	      		while(str != NULL)
-	      		{
-	         		switch (i)
-	         		{
-	         			case 1: citizenID = str; break;
-	         			case 2: firstName = str; break;
-	         			case 3: lastName = str; break;
-	         			case 4: country = str; break;
-	         			case 5: age = atoi(str); break;
-	         			case 6: virusName = str; break;	         	
-	         		}
-	         
-	         		i++;
-	         		str = strtok(NULL, " ");
-	      		}
-
-	      		if (i != 7)
-	      			printf("Error : unknown or invalid command\n\n");
+	      		if (tail == NULL)
+	      			printf("Error : not following any records file (use -f)\n\n");
 	      		else
-	      			vaccinateNow(vaccine_monitor, citizenID, firstName, lastName, country, age, virusName);
+	      			tail_print_stats(tail);
 	      	}
 
-	      	else if (!strcmp(str, "/list-nonVaccinated-Persons"))
+	      	else if (!strcmp(str, "/save"))
 	      	{
-	      		int i = 0;	      
+	      		int i = 0;
+	      		char * path;
 	      		while(str != NULL)
 	      		{
 	         		switch (i)
 	         		{
-	         			case 1: virusName = str; break;
+	         			case 1: path = str; break;
 	         		}
 
 	         		i++;
@@ -277,17 +599,27 @@ int main(int argc, char const *argv[])
 
 	      		if (i != 2)
 	      			printf("Error : unknown or invalid command\n\n");
-	      		else	  
-	      			list_nonVaccinated_Persons(vaccine_monitor, virusName);
+	      		else
+	      		{
+	      			if (wal != NULL)
+	      				wal_sync(wal);		// logged records stay on disk if the snapshot can not be saved
+	      			if (monitor_save(vaccine_monitor, path) == 0)
+	      			{
+	      				// every logged record is in the snapshot, so the log starts over from it (restart with -s path -w walFile)
+	      				if (wal != NULL)
+	      					wal_truncate(wal);
+	      				printf("Saved snapshot of monitor into %s\n\n", path);
+	      			}
+	      		}
 	      	}
 
 	      	else
 	      		printf("Error : unknown or invalid command\n\n");
 		}
 
+		if (pool != NULL && !benchmark)
+			query_pool_resume(pool);
 	}
 
-
-	fclose(file_ptr);
 	return 0;
 }
\ No newline at end of file